@@ -0,0 +1,408 @@
+#!/usr/bin/env python3
+"""Merge mfc_host parity output into one summary.
+
+    mfc_host --format binary --jobs 0 orig.dll rebuilt.dll test_files > results.bin
+    python aggregate_results.py results.bin
+    python aggregate_results.py part_*.bin --markdown summary.md --json results.json
+
+Inputs are mfc_host --format binary streams (layout in aud_host.h), the
+header-less record output of a --shard K/N worker, or mfc_host JSON. Any
+number of them are merged: the totals of each stream's summary record are
+added up, so shards run separately (or on other machines) give the same
+summary as one run. Records are decoded one at a time with struct, without
+building the JSON tree, and a stream cut off mid-record (a killed run) is
+read up to its last complete record and reported as incomplete.
+
+The summary lists totals (as in PARITY_TEST_RESULTS.md), per-format pass
+counts and sample diffs, per-export latency summed over the files both DLLs
+opened, and every failed file. --json writes the records in mfc_host's JSON
+schema (core fields, channels, memory and compare) for plot_scaling.py and
+perf_gate.py --host. For JSON input a file passes when the rebuilt record's
+compare block has the same structure and no mismatched samples, since the
+JSON carries no verdict; binary records carry mfc_host's own (including
+--max-ulp and every enabled check).
+
+Exit code 1 when any file failed or crashed.
+"""
+
+import argparse
+import glob
+import json
+import struct
+import sys
+from collections import defaultdict
+
+RESULTS_MAGIC = b"AUDRES01"
+RESULTS_VERSION = 4
+
+REC_RESULT = 1
+REC_COMPARE = 2
+REC_SUMMARY = 3
+
+# Packed little-endian structs, mirroring aud_host.h
+RECORD_HEADER = struct.Struct("<II")
+RESULT = struct.Struct("<BBxx6i3Ii12d5Q4q")
+CHANNEL = struct.Struct("<IIii2d2f")
+COMPARE = struct.Struct("<4B3I3Qdq")
+CHANNEL_COMPARE = struct.Struct("<IIiiIIQdq")
+SUMMARY = struct.Struct("<4I")
+
+RESULT_FIELDS = [
+    "dll", "heap_tracked",
+    "format_code", "open_ret", "num_files", "num_channels",
+    "total_channels", "sample_count", "session_magic", "path_len", "channel_count", "sniffed_format",
+    "interface_version", "dll_version", "first_sample", "last_sample",
+    "load_ms", "init_ms", "open_ms", "num_files_ms", "num_channels_ms", "size_query_ms",
+    "read_ms", "close_ms",
+    "working_set_before", "working_set_after", "peak_working_set",
+    "private_bytes_before", "private_bytes_after",
+    "heap_allocs", "heap_reallocs", "heap_frees", "heap_alloc_bytes",
+]
+CHANNEL_FIELDS = ["file_idx", "channel_idx", "ret", "sample_count", "first_sample", "last_sample",
+                  "size_query_ms", "read_ms"]
+COMPARE_FIELDS = ["ran", "structure_match", "passed", "has_divergence",
+                  "first_divergence_file_idx", "first_divergence_channel_idx", "channel_count",
+                  "samples", "mismatched_samples", "max_ulp", "max_abs_error", "first_divergence"]
+CHANNEL_COMPARE_FIELDS = ["file_idx", "channel_idx", "orig_ret", "rebuilt_ret", "orig_count",
+                          "rebuilt_count", "max_ulp", "max_abs_error", "first_divergence"]
+
+DLL_NAMES = ("original", "rebuilt")
+
+# Same names as format_name() in mfc_bench.cpp
+FORMAT_NAMES = {
+    1: "AudioMeasureEtm", 2: "AudioMeasureEfr", 3: "AudioMeasureEmd", 5: "AudioMeasureEtx",
+    9: "MsWave", 10: "MlssaTim", 11: "MlssaFrq", 12: "MonkeyForestDat", 13: "MonkeyForestSpk",
+    24: "ClioFreqText",
+}
+
+EXPORTS = [
+    ("load_ms", "LoadLibraryA"),
+    ("init_ms", "Aud_InitDll"),
+    ("open_ms", "Aud_OpenGetFile"),
+    ("num_files_ms", "Aud_GetNumberOfFiles"),
+    ("num_channels_ms", "Aud_GetNumberOfChannels"),
+    ("size_query_ms", "Aud_GetChannelDataDoubles(NULL)"),
+    ("read_ms", "Aud_GetChannelDataDoubles"),
+    ("close_ms", "Aud_CloseGetFile"),
+]
+
+
+def decode_result(payload):
+    r = dict(zip(RESULT_FIELDS, RESULT.unpack_from(payload, 0)))
+    pos = RESULT.size
+    r["file"] = bytes(payload[pos:pos + r["path_len"]]).decode("utf-8", "replace")
+    pos += r["path_len"]
+    channels = []
+    for _ in range(r["channel_count"]):
+        channels.append(dict(zip(CHANNEL_FIELDS, CHANNEL.unpack_from(payload, pos))))
+        pos += CHANNEL.size
+    r["channels"] = channels
+    return r
+
+
+def decode_compare(payload):
+    c = dict(zip(COMPARE_FIELDS, COMPARE.unpack_from(payload, 0)))
+    pos = COMPARE.size
+    per_channel = []
+    for _ in range(c["channel_count"]):
+        per_channel.append(dict(zip(CHANNEL_COMPARE_FIELDS, CHANNEL_COMPARE.unpack_from(payload, pos))))
+        pos += CHANNEL_COMPARE.size
+    c["per_channel"] = per_channel
+    return c
+
+
+def read_binary(data, start):
+    """Yield (type, payload) from offset start, then (None, offset) if the
+    last record runs past the end of the data."""
+    pos = start
+    view = memoryview(data)
+    while pos + RECORD_HEADER.size <= len(data):
+        size, rtype = RECORD_HEADER.unpack_from(data, pos)
+        body = pos + RECORD_HEADER.size
+        if body + size > len(data):
+            break
+        yield rtype, view[body:body + size]
+        pos = body + size
+    if pos != len(data):
+        yield None, pos
+
+
+def is_record_stream(data):
+    if len(data) < RECORD_HEADER.size:
+        return False
+    size, rtype = RECORD_HEADER.unpack_from(data, 0)
+    return rtype in (REC_RESULT, REC_COMPARE, REC_SUMMARY) and size < len(data)
+
+
+def json_verdict(orig, rebuilt):
+    cmp = rebuilt.get("compare")
+    if orig.get("open_ret") != rebuilt.get("open_ret"):
+        return False
+    if cmp is None:
+        return orig.get("open_ret") != 0 and rebuilt.get("open_ret") != 0
+    return bool(cmp["structure_match"]) and cmp["mismatched_samples"] == 0
+
+
+def json_compare(cmp, passed):
+    """Binary-style compare dict from a JSON compare block (or None)."""
+    if cmp is None:
+        return {"ran": 0, "passed": int(passed), "structure_match": 0, "samples": 0,
+                "mismatched_samples": 0, "max_ulp": 0, "max_abs_error": 0.0,
+                "has_divergence": 0, "per_channel": []}
+    div = cmp.get("first_divergence")
+    return {"ran": 1, "passed": int(passed), "structure_match": int(cmp["structure_match"]),
+            "samples": cmp["samples"], "mismatched_samples": cmp["mismatched_samples"],
+            "max_ulp": cmp["max_ulp"], "max_abs_error": cmp["max_abs_error"],
+            "has_divergence": int(div is not None),
+            "first_divergence_file_idx": div["file_idx"] if div else 0,
+            "first_divergence_channel_idx": div["channel_idx"] if div else 0,
+            "first_divergence": div["sample"] if div else -1,
+            "per_channel": cmp.get("per_channel", [])}
+
+
+def json_result(r):
+    """Binary-style result dict from a JSON record."""
+    out = dict(r)
+    out["dll"] = DLL_NAMES.index(r["dll"]) if r["dll"] in DLL_NAMES else 0
+    mem = r.get("memory", {})
+    out.update({k: mem.get(k) or 0 for k in ("working_set_before", "working_set_after", "peak_working_set",
+                                             "private_bytes_before", "private_bytes_after",
+                                             "heap_allocs", "heap_reallocs", "heap_frees",
+                                             "heap_alloc_bytes")})
+    out["heap_tracked"] = int(mem.get("heap_allocs") is not None)
+    out["session_magic"] = int(r.get("session_magic", "0"), 16)
+    return out
+
+
+class Aggregate:
+    def __init__(self, keep_records):
+        self.keep_records = keep_records
+        self.records = []
+        self.files = 0
+        self.passed = 0
+        self.crashed = 0
+        self.summary_files = 0
+        self.summary_passed = 0
+        self.summary_failed = 0
+        self.streams = 0
+        self.summaries = 0
+        self.incomplete = []
+        self.by_format = defaultdict(lambda: {"files": 0, "passed": 0, "samples": 0,
+                                              "mismatched": 0, "max_ulp": 0})
+        self.latency = {k: [0.0, 0.0] for k, _ in EXPORTS}
+        self.failures = []
+        self.pending = []
+
+    def add_result(self, r):
+        self.pending.append(r)
+        if self.keep_records:
+            self.records.append(r)
+
+    def add_compare(self, c):
+        """Closes the file whose two results came before it."""
+        results = self.pending[-2:]
+        self.pending = []
+        if len(results) != 2:
+            return
+        orig, rebuilt = results
+        self.files += 1
+        fmt = self.by_format[rebuilt["format_code"]]
+        fmt["files"] += 1
+        fmt["samples"] += c["samples"]
+        fmt["mismatched"] += c["mismatched_samples"]
+        fmt["max_ulp"] = max(fmt["max_ulp"], c["max_ulp"])
+        if c["passed"]:
+            self.passed += 1
+            fmt["passed"] += 1
+        else:
+            self.failures.append((rebuilt["file"], rebuilt["format_code"], orig["open_ret"],
+                                  rebuilt["open_ret"], c))
+        if orig["open_ret"] == 0 and rebuilt["open_ret"] == 0:
+            for key, _ in EXPORTS:
+                self.latency[key][0] += orig.get(key) or 0.0
+                self.latency[key][1] += rebuilt.get(key) or 0.0
+        if self.keep_records:
+            self.records[-1]["compare"] = c
+
+    def add_summary(self, s):
+        self.summaries += 1
+        self.summary_files += s[3]
+        self.summary_passed += s[0]
+        self.summary_failed += s[1]
+        self.crashed += s[2]
+
+    def load(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        self.streams += 1
+        if data.startswith(RESULTS_MAGIC):
+            version, = struct.unpack_from("<I", data, len(RESULTS_MAGIC))
+            if version != RESULTS_VERSION:
+                print(f"ERROR: {path}: stream version {version}, this script reads "
+                      f"version {RESULTS_VERSION}", file=sys.stderr)
+                sys.exit(2)
+            self.load_records(path, data, len(RESULTS_MAGIC) + 4, True)
+        elif is_record_stream(data):
+            self.load_records(path, data, 0, False)
+        else:
+            self.load_json(path, data)
+
+    def load_records(self, path, data, start, expect_summary):
+        have_summary = False
+        for rtype, payload in read_binary(data, start):
+            if rtype is None:
+                self.incomplete.append(f"{path}: truncated record at byte {payload}")
+                break
+            if rtype == REC_RESULT:
+                self.add_result(decode_result(payload))
+            elif rtype == REC_COMPARE:
+                self.add_compare(decode_compare(payload))
+            elif rtype == REC_SUMMARY:
+                self.add_summary(SUMMARY.unpack_from(payload, 0))
+                have_summary = True
+        if expect_summary and not have_summary:
+            self.incomplete.append(f"{path}: no summary record (run did not finish)")
+        self.pending = []
+
+    def load_json(self, path, data):
+        records = json.loads(data.decode("utf-8"))
+        for i in range(0, len(records) - 1, 2):
+            orig, rebuilt = records[i], records[i + 1]
+            self.add_result(json_result(orig))
+            self.add_result(json_result(rebuilt))
+            self.add_compare(json_compare(rebuilt.get("compare"), json_verdict(orig, rebuilt)))
+
+    def totals(self):
+        """(total, passed, failed, crashed). Workers that crashed left no records,
+        so their files are known only from the summary records."""
+        if self.summaries == self.streams and not self.incomplete:
+            total = max(self.summary_files, self.files + self.crashed)
+            passed = self.summary_passed
+            return total, passed, self.summary_failed - self.crashed, self.crashed
+        total = self.files + self.crashed
+        return total, self.passed, self.files - self.passed, self.crashed
+
+
+def pct(n, total):
+    return f"{100.0 * n / total:.0f}%" if total else "-"
+
+
+def print_markdown(agg, out):
+    total, passed, failed, crashed = agg.totals()
+    w = out.write
+    w("# Parity Summary\n\n")
+    w(f"{agg.streams} input(s), {agg.files} files with records\n\n")
+    for note in agg.incomplete:
+        w(f"**Incomplete:** {note}\n\n")
+    w("## Summary\n\n")
+    w("| Metric | Count | Status |\n")
+    w("|--------|-------|--------|\n")
+    w(f"| **Total Tests** | {total} | - |\n")
+    w(f"| **PASSED** | {passed} | {pct(passed, total)} |\n")
+    w(f"| **FAILED** | {failed} | {pct(failed, total)} |\n")
+    w(f"| **CRASHED** | {crashed} | {pct(crashed, total)} |\n\n")
+
+    w("## By Format\n\n")
+    w("| Format | Code | Files | Passed | Samples | Mismatched | Max ULP |\n")
+    w("|--------|------|-------|--------|---------|------------|---------|\n")
+    for code, f in sorted(agg.by_format.items()):
+        w(f"| {FORMAT_NAMES.get(code, 'AutoDetect')} | {code} | {f['files']} | {f['passed']} | "
+          f"{f['samples']} | {f['mismatched']} | {f['max_ulp']} |\n")
+    w("\n## Latency\n\n")
+    w("ms summed over the files both DLLs opened\n\n")
+    w("| Export | Original | Rebuilt | Ratio |\n")
+    w("|--------|----------|---------|-------|\n")
+    for key, name in EXPORTS:
+        o, r = agg.latency[key]
+        ratio = f"{r / o:.2f}x" if o > 0 else "-"
+        w(f"| {name} | {o:.3f} | {r:.3f} | {ratio} |\n")
+
+    if agg.failures:
+        w("\n## Failed\n\n")
+        w("| File | Format | Open (orig / rebuilt) | Mismatched | Max ULP | First divergence |\n")
+        w("|------|--------|-----------------------|------------|---------|------------------|\n")
+        for path, code, orig_ret, rebuilt_ret, c in agg.failures:
+            div = "-"
+            if c.get("has_divergence"):
+                div = (f"file {c['first_divergence_file_idx']} ch {c['first_divergence_channel_idx']} "
+                       f"sample {c['first_divergence']}")
+            w(f"| {path} | {code} | {orig_ret} / {rebuilt_ret} | {c['mismatched_samples']} | "
+              f"{c['max_ulp']} | {div} |\n")
+
+
+def to_json(r):
+    """mfc_host's JSON record schema for a decoded result (and its compare)."""
+    rec = {
+        "dll": DLL_NAMES[r["dll"]] if r["dll"] < len(DLL_NAMES) else str(r["dll"]),
+        "file": r["file"],
+        "interface_version": r["interface_version"],
+        "dll_version": r["dll_version"],
+        "session_magic": f"0x{r['session_magic']:08x}",
+    }
+    for key in ("load_ms", "init_ms"):
+        rec[key] = r[key]
+    rec["format_code"] = r["format_code"]
+    rec["sniffed_format"] = r["sniffed_format"]
+    for key in ("open_ret", "open_ms", "num_files", "num_files_ms", "num_channels", "num_channels_ms",
+                "size_query_ms", "read_ms", "close_ms", "total_channels", "sample_count",
+                "first_sample", "last_sample"):
+        rec[key] = r[key]
+    rec["channels"] = r["channels"]
+    mem = {k: r[k] for k in ("working_set_before", "working_set_after", "peak_working_set",
+                             "private_bytes_before", "private_bytes_after")}
+    mem["private_bytes_delta"] = r["private_bytes_after"] - r["private_bytes_before"]
+    if r["heap_tracked"]:
+        for k in ("heap_allocs", "heap_reallocs", "heap_frees", "heap_alloc_bytes"):
+            mem[k] = r[k]
+        mem["heap_outstanding"] = r["heap_allocs"] - r["heap_frees"]
+    else:
+        mem["heap_allocs"] = None
+    rec["memory"] = mem
+    c = r.get("compare")
+    if c and c["ran"]:
+        rec["compare"] = {
+            "structure_match": bool(c["structure_match"]),
+            "channels": len(c["per_channel"]),
+            "samples": c["samples"],
+            "mismatched_samples": c["mismatched_samples"],
+            "max_ulp": c["max_ulp"],
+            "max_abs_error": c["max_abs_error"],
+            "first_divergence": {"file_idx": c["first_divergence_file_idx"],
+                                 "channel_idx": c["first_divergence_channel_idx"],
+                                 "sample": c["first_divergence"]} if c["has_divergence"] else None,
+            "per_channel": c["per_channel"],
+        }
+    return rec
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("inputs", nargs="+", help="mfc_host --format binary streams or JSON (globs allowed)")
+    ap.add_argument("--markdown", help="Write the summary here instead of stdout")
+    ap.add_argument("--json", help="Write the merged records as mfc_host JSON")
+    args = ap.parse_args()
+
+    paths = []
+    for p in args.inputs:
+        paths.extend(sorted(glob.glob(p)) or [p])
+
+    agg = Aggregate(keep_records=bool(args.json))
+    for path in paths:
+        agg.load(path)
+
+    if args.markdown:
+        with open(args.markdown, "w", encoding="utf-8") as f:
+            print_markdown(agg, f)
+    else:
+        print_markdown(agg, sys.stdout)
+
+    if args.json:
+        with open(args.json, "w", encoding="utf-8") as f:
+            json.dump([to_json(r) for r in agg.records], f, indent=2)
+
+    _, _, failed, crashed = agg.totals()
+    return 1 if failed or crashed or agg.incomplete else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
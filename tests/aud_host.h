@@ -0,0 +1,1210 @@
+/*
+ * Shared helpers for the native target.dll hosts (mfc_host.cpp, mfc_bench.cpp)
+ *
+ * Export signatures, DLL loading, Aud_InitDll and the three-phase
+ * handshake, QueryPerformanceCounter
+ * timing, process memory counters, per-DLL heap allocation counting,
+ * corpus collection, the growable sample buffer and the binary result
+ * record writer. Each host is
+ * built as a single translation unit, so everything here is defined inline
+ * in the header.
+ */
+
+#pragma once
+
+#include <windows.h>
+#include <psapi.h>
+#include <fcntl.h>
+#include <io.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#pragma comment(lib, "psapi.lib")
+
+// DLL function signatures
+typedef double (__cdecl *Aud_GetInterfaceVersion_t)(void);
+typedef double (__cdecl *Aud_GetDllVersion_t)(void);
+typedef unsigned int (__cdecl *Aud_InitDll_t)(unsigned int magic);
+// CORRECTED: signature is (path, format_code, extra) not (format, path, hint)
+typedef int (__cdecl *Aud_OpenGetFile_t)(const wchar_t* path, int format, int extra);
+typedef int (__cdecl *Aud_GetNumberOfFiles_t)(unsigned int* out_count);
+typedef int (__cdecl *Aud_GetNumberOfChannels_t)(unsigned int file_idx, unsigned int* out_count);
+typedef int (__cdecl *Aud_CloseGetFile_t)(void);
+typedef int (__cdecl *Aud_GetChannelDataDoubles_t)(unsigned int file_idx, unsigned int channel_idx,
+                                                    double* buffer, unsigned int* count);
+typedef int (__cdecl *Aud_GetFileProperties_t)(unsigned int file_idx, void* props);
+typedef int (__cdecl *Aud_GetChannelProperties_t)(unsigned int file_idx, unsigned int channel_idx,
+                                                   void* props);
+typedef int (__cdecl *Aud_TextFileAOpenW_t)(const wchar_t* path, int mode);    // Handle or < 0
+typedef int (__cdecl *Aud_TextFileAClose_t)(int handle);
+typedef int (__cdecl *Aud_ReadLineAInFile_t)(int handle, char* buffer, unsigned int size);  // < 0 at EOF
+typedef int (__cdecl *Aud_OpenPutFile_t)(const wchar_t* path, int format);
+typedef int (__cdecl *Aud_PutNumberOfChannels_t)(unsigned int count);
+typedef int (__cdecl *Aud_PutFileProperties_t)(unsigned int file_idx, const void* props);
+typedef int (__cdecl *Aud_PutChannelProperties_t)(unsigned int file_idx, unsigned int channel_idx,
+                                                   const void* props);
+typedef int (__cdecl *Aud_PutChannelDataDoubles_t)(unsigned int file_idx, unsigned int channel_idx,
+                                                    const double* buffer, unsigned int count);
+typedef int (__cdecl *Aud_ClosePutFile_t)(void);
+typedef int (__cdecl *Aud_FileExistsW_t)(const wchar_t* path);
+typedef int (__cdecl *Aud_MakeDirW_t)(const wchar_t* path);
+// No size argument: the buffer must hold the channel's full sample count
+typedef int (__cdecl *Aud_GetChannelDataOriginal_t)(unsigned int file_idx, unsigned int channel_idx,
+                                                     short* buffer);
+typedef int (__cdecl *Aud_PutChannelDataOriginal_t)(unsigned int file_idx, unsigned int channel_idx,
+                                                     const short* buffer, unsigned int count);
+typedef int (__cdecl *Aud_GetFileHeaderOriginal_t)(unsigned int file_idx, void* buffer,
+                                                    unsigned int* out_size);
+typedef int (__cdecl *Aud_PutFileHeaderOriginal_t)(unsigned int file_idx, const void* buffer,
+                                                    unsigned int size);
+typedef int (__cdecl *Aud_GetString_t)(unsigned int string_id, char* buffer, unsigned int size);
+typedef int (__cdecl *Aud_PutString_t)(unsigned int string_id, const char* buffer);
+typedef int (__cdecl *Aud_GetLastWarnings_t)(char* buffer, unsigned int size);
+typedef int (__cdecl *Aud_GetErrDescription_t)(int code, char* buffer, unsigned int size);
+
+#define AUD_PROPS_SIZE 560  // File/channel property block; sample rate is the double at 0
+
+#define AUD_MAGIC 0x42754C2E
+
+// Three-phase Aud_InitDll handshake of the host application (init_dll_full)
+#define AUD_INIT_XOR_CONSTANT   1114983470u     // Phase 2: challenge ^ constant
+#define AUD_PHASE3_MAGIC        1230000000u     // Phase 3 argument ...
+#define AUD_PHASE3_XOR_RESULT   1826820242u     // ... returns AUD_PHASE3_MAGIC ^ this
+
+// Format codes from decompiled wrapper
+inline int format_from_extension(const wchar_t* path) {
+    const wchar_t* ext = wcsrchr(path, L'.');
+    if (!ext) return 0;
+
+    if (_wcsicmp(ext, L".etm") == 0) return 1;   // AudioMeasureEtm
+    if (_wcsicmp(ext, L".efr") == 0) return 2;   // AudioMeasureEfr
+    if (_wcsicmp(ext, L".emd") == 0) return 3;   // AudioMeasureEmd
+    if (_wcsicmp(ext, L".etx") == 0) return 5;   // AudioMeasureEtx
+    if (_wcsicmp(ext, L".wav") == 0) return 9;   // MsWave
+    if (_wcsicmp(ext, L".tim") == 0) return 10;  // MlssaTim
+    if (_wcsicmp(ext, L".frq") == 0) return 11;  // MlssaFrq
+    if (_wcsicmp(ext, L".dat") == 0) return 12;  // MonkeyForestDat
+    if (_wcsicmp(ext, L".spk") == 0) return 13;  // MonkeyForestSpk
+    if (_wcsicmp(ext, L".frd") == 0) return 24;  // ClioFreqText
+    if (_wcsicmp(ext, L".zma") == 0) return 24;  // ClioFreqText (impedance)
+    return 0;  // Auto-detect
+}
+
+// Magic-byte sniffing table, mirrored by FORMAT_MAGIC in parity_test.py.
+// Entries of one family share a signature and the extension picks among
+// them (first entry otherwise). Formats without a signature (numeric text
+// such as ETX, MonkeyForest SPK) are left to the extension.
+struct FormatMagic {
+    int format;             // Aud_OpenGetFile code, 0 = container the DLL auto-detects
+    const char* family;
+    unsigned int offset;
+    const char* magic;
+    unsigned int length;
+    unsigned int offset2;   // Second signature, length2 = 0 when unused
+    const char* magic2;
+    unsigned int length2;
+};
+
+static const FormatMagic g_format_magic[] = {
+    { 9,  "MsWave",          0, "RIFF", 4, 8, "WAVE", 4 },
+    { 1,  "Easera",          0, "SDA Easera  ", 12, 0, NULL, 0 },   // ETM
+    { 2,  "Easera",          0, "SDA Easera  ", 12, 0, NULL, 0 },   // EFR
+    { 3,  "AudioMeasureEmd", 0, "EASERA10MS", 10, 0, NULL, 0 },
+    { 10, "MlssaTim",        0, "\xcd\xab\xff\xff", 4, 0, NULL, 0 },
+    { 11, "MlssaFrq",        0, "\xde\xbc\xff\xff", 4, 0, NULL, 0 },
+    { 12, "MonkeyForestDat", 0, "M_D ", 4, 0, NULL, 0 },
+    { 0,  "ClioBinary",      0, "\x0b" "AUDIOMATICA", 12, 0, NULL, 0 },   // .mls/.frs/.imp
+};
+
+#define AUD_SNIFF_BYTES 512
+
+static inline bool magic_at(const unsigned char* head, unsigned int n, unsigned int offset,
+                            const char* magic, unsigned int length) {
+    return offset + length <= n && memcmp(head + offset, magic, length) == 0;
+}
+
+// Format code from the file's first AUD_SNIFF_BYTES, reported next to the
+// open; the open itself keeps the extension's code (get_format_code). A file whose extension names a
+// format with a signature it does not carry (test_mislabeled.etm,
+// malformed_bad_magic.wav) gets 0. family (optional) names the match,
+// "extension" when the code came from the extension alone, "unknown" when
+// nothing matched.
+inline int sniff_format(const wchar_t* path, const char** family = NULL) {
+    const size_t entries = sizeof(g_format_magic) / sizeof(g_format_magic[0]);
+    int ext_format = format_from_extension(path);
+    if (family) *family = "extension";
+
+    HANDLE h = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                           OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (h == INVALID_HANDLE_VALUE) return ext_format;    // Not there yet (write paths)
+    unsigned char head[AUD_SNIFF_BYTES];
+    DWORD n = 0;
+    if (!ReadFile(h, head, sizeof(head), &n, NULL)) n = 0;
+    CloseHandle(h);
+
+    const FormatMagic* match = NULL;
+    for (size_t i = 0; i < entries; i++) {
+        const FormatMagic& m = g_format_magic[i];
+        if (!magic_at(head, n, m.offset, m.magic, m.length)) continue;
+        if (m.length2 && !magic_at(head, n, m.offset2, m.magic2, m.length2)) continue;
+        if (match && strcmp(match->family, m.family) != 0) break;
+        if (!match || m.format == ext_format) match = &m;
+    }
+    if (match) {
+        if (family) *family = match->family;
+        return match->format;
+    }
+
+    for (size_t i = 0; i < entries; i++) {
+        if (ext_format != 0 && g_format_magic[i].format == ext_format) {
+            if (family) *family = "unknown";
+            return 0;
+        }
+    }
+    return ext_format;
+}
+
+// sniff_format for the last path asked about, re-read only when the path,
+// size or write time changes (the fuzz and roundtrip modes rewrite theirs).
+inline int sniffed_format_code(const wchar_t* path, const char** family = NULL) {
+    static std::wstring cached_path;
+    static WIN32_FILE_ATTRIBUTE_DATA cached_attr;
+    static int cached_format = 0;
+    static const char* cached_family = "extension";
+
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+    if (!GetFileAttributesExW(path, GetFileExInfoStandard, &attr)) {
+        cached_path.clear();
+        return sniff_format(path, family);
+    }
+    if (cached_path != path ||
+        attr.nFileSizeLow != cached_attr.nFileSizeLow ||
+        attr.nFileSizeHigh != cached_attr.nFileSizeHigh ||
+        memcmp(&attr.ftLastWriteTime, &cached_attr.ftLastWriteTime, sizeof(FILETIME)) != 0) {
+        cached_format = sniff_format(path, &cached_family);
+        cached_path = path;
+        cached_attr = attr;
+    }
+    if (family) *family = cached_family;
+    return cached_format;
+}
+
+// Format code for Aud_OpenGetFile: the extension's parser, so malformed
+// fixtures still reach its error paths rather than auto-detection.
+inline int get_format_code(const wchar_t* path) {
+    return format_from_extension(path);
+}
+
+// Formats parsed from numeric text (ETX, CLIO FRD/ZMA, CLIO/LMS .txt exports)
+inline bool is_text_format(const wchar_t* path) {
+    const wchar_t* ext = wcsrchr(path, L'.');
+    if (!ext) return false;
+    return _wcsicmp(ext, L".etx") == 0 || _wcsicmp(ext, L".frd") == 0 ||
+           _wcsicmp(ext, L".zma") == 0 || _wcsicmp(ext, L".txt") == 0;
+}
+
+// ============================================================================
+// Timing
+// ============================================================================
+
+static double g_ms_per_tick = 0.0;
+
+inline void timer_init() {
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    g_ms_per_tick = 1000.0 / (double)freq.QuadPart;
+}
+
+static inline LONGLONG timer_now() {
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t.QuadPart;
+}
+
+static inline double timer_ms(LONGLONG start, LONGLONG end) {
+    return (double)(end - start) * g_ms_per_tick;
+}
+
+// SLOWER in the end-of-run tables uses perf_gate.py's defaults: more than
+// SLOWER_PCT percent over the original and at least SLOWER_MIN_MS more, so
+// timer noise on sub-millisecond totals is not flagged
+#define SLOWER_PCT      10.0
+#define SLOWER_MIN_MS   0.5
+
+inline bool is_slower(double orig_ms, double rebuilt_ms) {
+    return rebuilt_ms > orig_ms * (1.0 + SLOWER_PCT / 100.0) && rebuilt_ms - orig_ms >= SLOWER_MIN_MS;
+}
+
+// HDR-style latency histogram: nanosecond values in power-of-two ranges,
+// each split into LATENCY_HALF linear sub-buckets, so every value is kept
+// to within 1/32 (~3%) with fixed memory and O(1) recording. Values below
+// 2 * LATENCY_HALF ns are exact; longer than 2^LATENCY_MAX_BITS ns (about
+// 4.9 hours) are clamped.
+#define LATENCY_SUB_BITS    6
+#define LATENCY_HALF        (1u << (LATENCY_SUB_BITS - 1))
+#define LATENCY_MAX_BITS    44
+#define LATENCY_BUCKETS     (LATENCY_HALF * (LATENCY_MAX_BITS - LATENCY_SUB_BITS + 3))
+
+struct LatencyHistogram {
+    unsigned long long counts[LATENCY_BUCKETS];
+    unsigned long long total;
+    unsigned long long max_ns;
+    double sum_ns;
+};
+
+inline unsigned int latency_bucket(unsigned long long ns) {
+    if (ns >= (1ULL << LATENCY_MAX_BITS)) ns = (1ULL << LATENCY_MAX_BITS) - 1;
+    if (ns < 2 * LATENCY_HALF) return (unsigned int)ns;
+    unsigned int msb = 63;
+    while (!(ns >> msb)) msb--;
+    unsigned int shift = msb - (LATENCY_SUB_BITS - 1);
+    return LATENCY_HALF * shift + (unsigned int)(ns >> shift);
+}
+
+// Largest value that lands in the bucket
+inline unsigned long long latency_bucket_upper(unsigned int bucket) {
+    if (bucket < 2 * LATENCY_HALF) return bucket;
+    unsigned int shift = bucket / LATENCY_HALF - 1;
+    unsigned long long sub = bucket - LATENCY_HALF * shift;
+    return ((sub + 1) << shift) - 1;
+}
+
+inline void latency_reset(LatencyHistogram& h) {
+    memset(&h, 0, sizeof(h));
+}
+
+inline void latency_record(LatencyHistogram& h, double ms) {
+    unsigned long long ns = ms > 0.0 ? (unsigned long long)(ms * 1e6 + 0.5) : 0;
+    h.counts[latency_bucket(ns)]++;
+    h.total++;
+    h.sum_ns += (double)ns;
+    if (ns > h.max_ns) h.max_ns = ns;
+}
+
+inline void latency_merge(LatencyHistogram& into, const LatencyHistogram& h) {
+    for (unsigned int b = 0; b < LATENCY_BUCKETS; b++) into.counts[b] += h.counts[b];
+    into.total += h.total;
+    into.sum_ns += h.sum_ns;
+    if (h.max_ns > into.max_ns) into.max_ns = h.max_ns;
+}
+
+// Value at quantile q (0..1) in ms: upper bound of the bucket holding it
+inline double latency_percentile_ms(const LatencyHistogram& h, double q) {
+    if (h.total == 0) return 0.0;
+    unsigned long long rank = (unsigned long long)(q * (double)h.total + 0.999999);
+    if (rank < 1) rank = 1;
+    unsigned long long seen = 0;
+    for (unsigned int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += h.counts[b];
+        if (seen >= rank) {
+            unsigned long long upper = latency_bucket_upper(b);
+            return (double)(upper < h.max_ns ? upper : h.max_ns) / 1e6;
+        }
+    }
+    return (double)h.max_ns / 1e6;
+}
+
+// {"count", "mean_ms", "p50_ms" .. "p9999_ms", "max_ms", "buckets": [[upper_ns, count], ...]}
+// with only the non-empty buckets, so histograms from several runs can be merged
+inline void print_json_latency(const LatencyHistogram& h) {
+    printf("{\"count\": %llu, \"mean_ms\": %.6f, \"p50_ms\": %.6f, \"p90_ms\": %.6f, "
+           "\"p99_ms\": %.6f, \"p999_ms\": %.6f, \"p9999_ms\": %.6f, \"max_ms\": %.6f, \"buckets\": [",
+           h.total, h.total ? h.sum_ns / (double)h.total / 1e6 : 0.0,
+           latency_percentile_ms(h, 0.50), latency_percentile_ms(h, 0.90),
+           latency_percentile_ms(h, 0.99), latency_percentile_ms(h, 0.999),
+           latency_percentile_ms(h, 0.9999), (double)h.max_ns / 1e6);
+    bool first = true;
+    for (unsigned int b = 0; b < LATENCY_BUCKETS; b++) {
+        if (!h.counts[b]) continue;
+        printf("%s[%llu, %llu]", first ? "" : ", ", latency_bucket_upper(b), h.counts[b]);
+        first = false;
+    }
+    printf("]}");
+}
+
+// Growable sample buffer, reused across channels and files
+struct SampleBuffer {
+    double* data;
+    size_t capacity;
+};
+
+// Largest channel a sample buffer holds. The hosts are 32-bit: 2 GB of
+// address space has to fit both DLLs' decoded data plus the host's original
+// and rebuilt buffers, so a channel past 2^26 samples (512 MB of doubles) is
+// refused instead of wrapping size_t or half-allocating. 64-bit builds allow
+// 2^34 samples.
+#define SAMPLE_BUFFER_MAX   ((size_t)1 << (sizeof(size_t) == 4 ? 26 : 34))
+
+// False (buffer unchanged) when count exceeds SAMPLE_BUFFER_MAX or the
+// allocation fails
+inline bool buffer_reserve(SampleBuffer& buf, size_t count) {
+    if (count <= buf.capacity) return true;
+    if (count > SAMPLE_BUFFER_MAX) return false;
+    size_t cap = buf.capacity ? buf.capacity : 4096;
+    while (cap < count) cap = cap > SAMPLE_BUFFER_MAX / 2 ? SAMPLE_BUFFER_MAX : cap * 2;
+    double* p = (double*)realloc(buf.data, cap * sizeof(double));
+    if (!p) return false;
+    buf.data = p;
+    buf.capacity = cap;
+    return true;
+}
+
+inline void buffer_free(SampleBuffer& buf) {
+    free(buf.data);
+    buf.data = NULL;
+    buf.capacity = 0;
+}
+
+// Process memory counters in bytes. The peak_* fields are high-water marks
+// since process start, so per-file peaks need a fresh process per file.
+struct MemorySnapshot {
+    unsigned long long working_set;
+    unsigned long long peak_working_set;
+    unsigned long long private_bytes;
+    unsigned long long peak_commit;
+};
+
+inline MemorySnapshot memory_snapshot() {
+    MemorySnapshot m = {};
+    PROCESS_MEMORY_COUNTERS_EX pmc;
+    memset(&pmc, 0, sizeof(pmc));
+    pmc.cb = sizeof(pmc);
+    if (GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc))) {
+        m.working_set = pmc.WorkingSetSize;
+        m.peak_working_set = pmc.PeakWorkingSetSize;
+        m.private_bytes = pmc.PrivateUsage;
+        m.peak_commit = pmc.PeakPagefileUsage;
+    }
+    return m;
+}
+
+// Free and busy blocks of every heap in the process (HeapWalk). The CRT
+// heap the DLLs allocate from is one of them. fragmentation_pct is the share
+// of free committed bytes outside the largest free block: 0 when all free
+// space is one block, near 100 when it is scattered between live blocks.
+struct HeapWalkStats {
+    unsigned int heaps;
+    unsigned long long committed_bytes;
+    unsigned long long busy_bytes;
+    unsigned long long busy_blocks;
+    unsigned long long free_bytes;
+    unsigned long long free_blocks;
+    unsigned long long largest_free;
+    double fragmentation_pct;
+};
+
+inline HeapWalkStats heap_walk_stats() {
+    HeapWalkStats st = {};
+    HANDLE heaps[64];
+    DWORD n = GetProcessHeaps(64, heaps);
+    if (n > 64) n = 64;
+    for (DWORD h = 0; h < n; h++) {
+        if (!HeapLock(heaps[h])) continue;
+        st.heaps++;
+        PROCESS_HEAP_ENTRY e;
+        memset(&e, 0, sizeof(e));
+        while (HeapWalk(heaps[h], &e)) {
+            if (e.wFlags & PROCESS_HEAP_REGION) {
+                continue;
+            } else if (e.wFlags & PROCESS_HEAP_UNCOMMITTED_RANGE) {
+                continue;
+            } else if (e.wFlags & PROCESS_HEAP_ENTRY_BUSY) {
+                st.busy_blocks++;
+                st.busy_bytes += e.cbData;
+            } else {
+                st.free_blocks++;
+                st.free_bytes += e.cbData;
+                if (e.cbData > st.largest_free) st.largest_free = e.cbData;
+            }
+            st.committed_bytes += e.cbData + e.cbOverhead;
+        }
+        HeapUnlock(heaps[h]);
+    }
+    st.fragmentation_pct = st.free_bytes > 0
+        ? 100.0 * (double)(st.free_bytes - st.largest_free) / (double)st.free_bytes : 0.0;
+    return st;
+}
+
+// Pages of a loaded DLL image: VirtualQuery over its allocation for the
+// committed ones, QueryWorkingSetEx for residency. private_pages are
+// resident pages no longer shared with the file mapping, i.e. written by
+// this process (relocations, .data, what DllMain and static constructors
+// touched), which every extra worker process pays for again.
+struct ImagePages {
+    unsigned int committed;
+    unsigned int resident;
+    unsigned int private_pages;
+};
+
+inline ImagePages image_pages(HMODULE module) {
+    ImagePages p = {};
+    if (!module) return p;
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages;
+    const char* addr = (const char*)module;
+    MEMORY_BASIC_INFORMATION mbi;
+    while (VirtualQuery(addr, &mbi, sizeof(mbi)) == sizeof(mbi) && mbi.AllocationBase == (void*)module) {
+        if (mbi.State == MEM_COMMIT) {
+            for (SIZE_T off = 0; off < mbi.RegionSize; off += si.dwPageSize) {
+                PSAPI_WORKING_SET_EX_INFORMATION info;
+                memset(&info, 0, sizeof(info));
+                info.VirtualAddress = (void*)(addr + off);
+                pages.push_back(info);
+            }
+        }
+        addr += mbi.RegionSize;
+    }
+    p.committed = (unsigned int)pages.size();
+    if (pages.empty() || !QueryWorkingSetEx(GetCurrentProcess(), &pages[0],
+                                            (DWORD)(pages.size() * sizeof(pages[0])))) {
+        return p;
+    }
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (!pages[i].VirtualAttributes.Valid) continue;
+        p.resident++;
+        if (!pages[i].VirtualAttributes.Shared) p.private_pages++;
+    }
+    return p;
+}
+
+// One loaded and initialized copy of target.dll
+struct AudDll {
+    const char* dll_name;
+    HMODULE module;
+    double interface_version;
+    double dll_version;
+    unsigned int session_magic;
+    double init_ms;
+    double load_ms;             // LoadLibraryA alone (mapping, imports, DllMain)
+    long long load_commit;      // Private bytes committed by LoadLibraryA
+    int heap_slot;          // heap_counters() slot, -1 when not tracked
+
+    Aud_GetInterfaceVersion_t Aud_GetInterfaceVersion;
+    Aud_GetDllVersion_t Aud_GetDllVersion;
+    Aud_InitDll_t Aud_InitDll;
+    Aud_OpenGetFile_t Aud_OpenGetFile;
+    Aud_GetNumberOfFiles_t Aud_GetNumberOfFiles;
+    Aud_GetNumberOfChannels_t Aud_GetNumberOfChannels;
+    Aud_CloseGetFile_t Aud_CloseGetFile;
+    Aud_GetChannelDataDoubles_t Aud_GetChannelDataDoubles;
+    Aud_GetFileProperties_t Aud_GetFileProperties;
+    Aud_GetChannelProperties_t Aud_GetChannelProperties;
+    Aud_TextFileAOpenW_t Aud_TextFileAOpenW;
+    Aud_TextFileAClose_t Aud_TextFileAClose;
+    Aud_ReadLineAInFile_t Aud_ReadLineAInFile;
+    Aud_OpenPutFile_t Aud_OpenPutFile;
+    Aud_PutNumberOfChannels_t Aud_PutNumberOfChannels;
+    Aud_PutFileProperties_t Aud_PutFileProperties;
+    Aud_PutChannelProperties_t Aud_PutChannelProperties;
+    Aud_PutChannelDataDoubles_t Aud_PutChannelDataDoubles;
+    Aud_ClosePutFile_t Aud_ClosePutFile;
+    Aud_FileExistsW_t Aud_FileExistsW;
+    Aud_MakeDirW_t Aud_MakeDirW;
+    Aud_GetChannelDataOriginal_t Aud_GetChannelDataOriginal;
+    Aud_PutChannelDataOriginal_t Aud_PutChannelDataOriginal;
+    Aud_GetFileHeaderOriginal_t Aud_GetFileHeaderOriginal;
+    Aud_PutFileHeaderOriginal_t Aud_PutFileHeaderOriginal;
+    Aud_GetString_t Aud_GetString;
+    Aud_PutString_t Aud_PutString;
+    Aud_GetLastWarnings_t Aud_GetLastWarnings;
+    Aud_GetErrDescription_t Aud_GetErrDescription;
+};
+
+// Print a string as a JSON string literal (Windows paths contain backslashes)
+inline void print_json_string(const char* s) {
+    putchar('"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            printf("\\%c", c);
+        } else if (c < 0x20) {
+            printf("\\u%04x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+// ============================================================================
+// Binary result records (mfc_host --format binary)
+//
+// Little endian, read by aggregate_results.py:
+//   AUD_RESULTS_MAGIC, uint32 AUD_RESULTS_VERSION
+//   records: AudRecordHeader, then size bytes of payload
+// Payloads are packed structs, variable parts following the fixed one:
+//   AUD_REC_RESULT   AudResultRecord, path_len bytes of UTF-8 path,
+//                    AudChannelRecord[channel_count]
+//   AUD_REC_COMPARE  AudCompareRecord, AudChannelCompareRecord[channel_count]
+//                    (after the rebuilt DLL's result for the same file)
+//   AUD_REC_SUMMARY  AudSummaryRecord, last in a complete stream
+// Readers skip record types they do not know by size and stop at a record
+// that runs past the end of the stream (a writer that died mid-record). Any
+// change to a struct bumps AUD_RESULTS_VERSION.
+// ============================================================================
+
+#define AUD_RESULTS_MAGIC       "AUDRES01"      // 8 bytes, no terminator
+#define AUD_RESULTS_VERSION     4
+
+#define AUD_REC_RESULT          1
+#define AUD_REC_COMPARE         2
+#define AUD_REC_SUMMARY         3
+
+#pragma pack(push, 1)
+
+struct AudRecordHeader {
+    unsigned int size;          // Payload bytes after this header
+    unsigned int type;          // AUD_REC_*
+};
+
+struct AudResultRecord {
+    unsigned char dll;          // 0 original, 1 rebuilt
+    unsigned char heap_tracked; // 0: heap_* fields are not meaningful
+    unsigned char reserved[2];
+    int format_code;
+    int open_ret;
+    int num_files;
+    int num_channels;
+    int total_channels;
+    int sample_count;
+    unsigned int session_magic;
+    unsigned int path_len;
+    unsigned int channel_count;
+    int sniffed_format;
+    double interface_version;
+    double dll_version;
+    double first_sample;
+    double last_sample;
+    double load_ms;
+    double init_ms;
+    double open_ms;
+    double num_files_ms;
+    double num_channels_ms;
+    double size_query_ms;
+    double read_ms;
+    double close_ms;
+    unsigned long long working_set_before;
+    unsigned long long working_set_after;
+    unsigned long long peak_working_set;
+    unsigned long long private_bytes_before;
+    unsigned long long private_bytes_after;
+    long long heap_allocs;
+    long long heap_reallocs;
+    long long heap_frees;
+    long long heap_alloc_bytes;
+};
+
+struct AudChannelRecord {
+    unsigned int file_idx;
+    unsigned int channel_idx;
+    int ret;
+    int sample_count;
+    double first_sample;
+    double last_sample;
+    float size_query_ms;
+    float read_ms;
+};
+
+struct AudCompareRecord {
+    unsigned char ran;          // 0: one of the DLLs could not be compared
+    unsigned char structure_match;
+    unsigned char passed;       // Verdict for the file, every enabled check included
+    unsigned char has_divergence;
+    unsigned int first_divergence_file_idx;
+    unsigned int first_divergence_channel_idx;
+    unsigned int channel_count;
+    unsigned long long samples;
+    unsigned long long mismatched_samples;
+    unsigned long long max_ulp;
+    double max_abs_error;
+    long long first_divergence; // Sample index, -1 = none
+};
+
+struct AudChannelCompareRecord {
+    unsigned int file_idx;
+    unsigned int channel_idx;
+    int orig_ret;
+    int rebuilt_ret;
+    unsigned int orig_count;
+    unsigned int rebuilt_count;
+    unsigned long long max_ulp;
+    double max_abs_error;
+    long long first_divergence; // -1 = none
+};
+
+struct AudSummaryRecord {
+    unsigned int passed;
+    unsigned int failed;        // Includes crashed
+    unsigned int crashed;       // Files of workers that crashed or timed out
+    unsigned int files;
+};
+
+#pragma pack(pop)
+
+// Records are assembled in one buffer, allocated once and grown only for a
+// record larger than it, and written out in whole records with fwrite
+#define RECORD_BUFFER_BYTES     (1u << 20)
+
+struct RecordWriter {
+    FILE* out;
+    unsigned char* data;
+    size_t capacity;
+    size_t used;
+    size_t record_start;        // Offset of the open record's header
+};
+
+// Put out in binary mode and allocate the buffer. header = false for
+// --shard workers, whose records the parent splices into its own stream.
+inline bool record_open(RecordWriter& w, FILE* out, bool header) {
+    w.out = out;
+    w.capacity = RECORD_BUFFER_BYTES;
+    w.data = (unsigned char*)malloc(w.capacity);
+    w.used = 0;
+    w.record_start = 0;
+    if (!w.data) return false;
+    fflush(out);
+    _setmode(_fileno(out), _O_BINARY);
+    if (header) {
+        unsigned int version = AUD_RESULTS_VERSION;
+        memcpy(w.data, AUD_RESULTS_MAGIC, 8);
+        memcpy(w.data + 8, &version, sizeof(version));
+        w.used = 12;
+        w.record_start = w.used;
+    }
+    return true;
+}
+
+// Write out every complete record
+inline void record_flush(RecordWriter& w) {
+    size_t done = w.record_start < w.used ? w.record_start : w.used;
+    if (done > 0) {
+        fwrite(w.data, 1, done, w.out);
+        memmove(w.data, w.data + done, w.used - done);
+        w.used -= done;
+        w.record_start -= done;
+    }
+    fflush(w.out);
+}
+
+inline void record_put(RecordWriter& w, const void* p, size_t n) {
+    if (w.used + n > w.capacity) {
+        record_flush(w);
+        size_t cap = w.capacity;
+        while (w.used + n > cap) cap *= 2;
+        if (cap != w.capacity) {
+            unsigned char* grown = (unsigned char*)realloc(w.data, cap);
+            if (!grown) {
+                fprintf(stderr, "ERROR: out of memory for a %u-byte result record\n", (unsigned)(w.used + n));
+                return;
+            }
+            w.data = grown;
+            w.capacity = cap;
+        }
+    }
+    memcpy(w.data + w.used, p, n);
+    w.used += n;
+}
+
+inline void record_begin(RecordWriter& w, unsigned int type) {
+    w.record_start = w.used;
+    AudRecordHeader h = { 0, type };
+    record_put(w, &h, sizeof(h));
+}
+
+// Patch the open record's size; flush once the buffer is half full
+inline void record_end(RecordWriter& w) {
+    unsigned int size = (unsigned int)(w.used - w.record_start - sizeof(AudRecordHeader));
+    memcpy(w.data + w.record_start, &size, sizeof(size));
+    w.record_start = w.used;
+    if (w.used >= w.capacity / 2) record_flush(w);
+}
+
+inline void record_close(RecordWriter& w) {
+    w.record_start = w.used;
+    record_flush(w);
+    free(w.data);
+    w.data = NULL;
+}
+
+inline void record_summary(RecordWriter& w, unsigned int passed, unsigned int failed,
+                           unsigned int crashed, unsigned int files) {
+    AudSummaryRecord s = { passed, failed, crashed, files };
+    record_begin(w, AUD_REC_SUMMARY);
+    record_put(w, &s, sizeof(s));
+    record_end(w);
+}
+
+// Load the DLL, resolve its exports and run Aud_InitDll(AUD_MAGIC) once
+// (skipped with init == false, e.g. before init_dll_full).
+// Returns false (with dll.module == NULL) if the DLL cannot be used.
+inline bool load_dll(AudDll& dll, const char* dll_path, const char* dll_name, bool init = true) {
+    memset(&dll, 0, sizeof(dll));
+    dll.dll_name = dll_name;
+    dll.heap_slot = -1;
+
+    // Change to DLL directory for any dependencies
+    char dll_dir[MAX_PATH];
+    strcpy_s(dll_dir, dll_path);
+    char* last_slash = strrchr(dll_dir, '\\');
+    if (!last_slash) last_slash = strrchr(dll_dir, '/');
+    if (last_slash) *last_slash = '\0';
+
+    char old_dir[MAX_PATH];
+    GetCurrentDirectoryA(MAX_PATH, old_dir);
+    SetCurrentDirectoryA(dll_dir);
+
+    MemorySnapshot before = memory_snapshot();
+    LONGLONG t0 = timer_now();
+    HMODULE hDll = LoadLibraryA(dll_path);
+    dll.load_ms = timer_ms(t0, timer_now());
+    dll.load_commit = (long long)memory_snapshot().private_bytes - (long long)before.private_bytes;
+    SetCurrentDirectoryA(old_dir);
+
+    if (!hDll) {
+        fprintf(stderr, "ERROR: Failed to load DLL: %s (error %lu)\n", dll_path, GetLastError());
+        return false;
+    }
+
+    // Get function pointers
+    dll.Aud_GetInterfaceVersion =
+        (Aud_GetInterfaceVersion_t)GetProcAddress(hDll, "Aud_GetInterfaceVersion");
+    dll.Aud_GetDllVersion =
+        (Aud_GetDllVersion_t)GetProcAddress(hDll, "Aud_GetDllVersion");
+    dll.Aud_InitDll =
+        (Aud_InitDll_t)GetProcAddress(hDll, "Aud_InitDll");
+    dll.Aud_OpenGetFile =
+        (Aud_OpenGetFile_t)GetProcAddress(hDll, "Aud_OpenGetFile");
+    dll.Aud_GetNumberOfFiles =
+        (Aud_GetNumberOfFiles_t)GetProcAddress(hDll, "Aud_GetNumberOfFiles");
+    dll.Aud_GetNumberOfChannels =
+        (Aud_GetNumberOfChannels_t)GetProcAddress(hDll, "Aud_GetNumberOfChannels");
+    dll.Aud_CloseGetFile =
+        (Aud_CloseGetFile_t)GetProcAddress(hDll, "Aud_CloseGetFile");
+    dll.Aud_GetChannelDataDoubles =
+        (Aud_GetChannelDataDoubles_t)GetProcAddress(hDll, "Aud_GetChannelDataDoubles");
+    dll.Aud_GetFileProperties =
+        (Aud_GetFileProperties_t)GetProcAddress(hDll, "Aud_GetFileProperties");
+    dll.Aud_GetChannelProperties =
+        (Aud_GetChannelProperties_t)GetProcAddress(hDll, "Aud_GetChannelProperties");
+    dll.Aud_TextFileAOpenW =
+        (Aud_TextFileAOpenW_t)GetProcAddress(hDll, "Aud_TextFileAOpenW");
+    dll.Aud_TextFileAClose =
+        (Aud_TextFileAClose_t)GetProcAddress(hDll, "Aud_TextFileAClose");
+    dll.Aud_ReadLineAInFile =
+        (Aud_ReadLineAInFile_t)GetProcAddress(hDll, "Aud_ReadLineAInFile");
+    dll.Aud_OpenPutFile =
+        (Aud_OpenPutFile_t)GetProcAddress(hDll, "Aud_OpenPutFile");
+    dll.Aud_PutNumberOfChannels =
+        (Aud_PutNumberOfChannels_t)GetProcAddress(hDll, "Aud_PutNumberOfChannels");
+    dll.Aud_PutFileProperties =
+        (Aud_PutFileProperties_t)GetProcAddress(hDll, "Aud_PutFileProperties");
+    dll.Aud_PutChannelProperties =
+        (Aud_PutChannelProperties_t)GetProcAddress(hDll, "Aud_PutChannelProperties");
+    dll.Aud_PutChannelDataDoubles =
+        (Aud_PutChannelDataDoubles_t)GetProcAddress(hDll, "Aud_PutChannelDataDoubles");
+    dll.Aud_ClosePutFile =
+        (Aud_ClosePutFile_t)GetProcAddress(hDll, "Aud_ClosePutFile");
+    dll.Aud_FileExistsW =
+        (Aud_FileExistsW_t)GetProcAddress(hDll, "Aud_FileExistsW");
+    dll.Aud_MakeDirW =
+        (Aud_MakeDirW_t)GetProcAddress(hDll, "Aud_MakeDirW");
+    dll.Aud_GetChannelDataOriginal =
+        (Aud_GetChannelDataOriginal_t)GetProcAddress(hDll, "Aud_GetChannelDataOriginal");
+    dll.Aud_PutChannelDataOriginal =
+        (Aud_PutChannelDataOriginal_t)GetProcAddress(hDll, "Aud_PutChannelDataOriginal");
+    dll.Aud_GetFileHeaderOriginal =
+        (Aud_GetFileHeaderOriginal_t)GetProcAddress(hDll, "Aud_GetFileHeaderOriginal");
+    dll.Aud_PutFileHeaderOriginal =
+        (Aud_PutFileHeaderOriginal_t)GetProcAddress(hDll, "Aud_PutFileHeaderOriginal");
+    dll.Aud_GetString =
+        (Aud_GetString_t)GetProcAddress(hDll, "Aud_GetString");
+    dll.Aud_PutString =
+        (Aud_PutString_t)GetProcAddress(hDll, "Aud_PutString");
+    dll.Aud_GetLastWarnings =
+        (Aud_GetLastWarnings_t)GetProcAddress(hDll, "Aud_GetLastWarnings");
+    dll.Aud_GetErrDescription =
+        (Aud_GetErrDescription_t)GetProcAddress(hDll, "Aud_GetErrDescription");
+
+    if (!dll.Aud_InitDll || !dll.Aud_OpenGetFile) {
+        fprintf(stderr, "ERROR: Failed to get function pointers from %s\n", dll_path);
+        FreeLibrary(hDll);
+        return false;
+    }
+    dll.module = hDll;
+
+    // Get versions
+    if (dll.Aud_GetInterfaceVersion) {
+        dll.interface_version = dll.Aud_GetInterfaceVersion();
+    }
+    if (dll.Aud_GetDllVersion) {
+        dll.dll_version = dll.Aud_GetDllVersion();
+    }
+
+    if (!init) return true;
+
+    // Initialize
+    t0 = timer_now();
+    dll.session_magic = dll.Aud_InitDll(AUD_MAGIC);
+    dll.init_ms = timer_ms(t0, timer_now());
+    if (dll.session_magic == 0) {
+        fprintf(stderr, "WARNING: Aud_InitDll returned 0 for %s\n", dll_name);
+    }
+    return true;
+}
+
+// Three-phase challenge-response init the host application performs, which
+// the original DLL needs before file I/O (parity_test.py init_dll_full).
+// A DLL loaded with init == false gets exactly these three calls. On
+// failure message says which phase went wrong.
+inline bool init_dll_full(AudDll& dll, char* message, size_t size) {
+    LONGLONG t0 = timer_now();
+    unsigned int challenge = dll.Aud_InitDll(0);
+    unsigned int response = challenge ^ AUD_INIT_XOR_CONSTANT;
+    unsigned int result = dll.Aud_InitDll(response);
+    if (result != 0) {
+        dll.init_ms = timer_ms(t0, timer_now());
+        sprintf_s(message, size, "Phase 2 failed: Aud_InitDll(%u) returned %u", response, result);
+        return false;
+    }
+    result = dll.Aud_InitDll(AUD_PHASE3_MAGIC);
+    dll.init_ms = timer_ms(t0, timer_now());
+    unsigned int expected = AUD_PHASE3_MAGIC ^ AUD_PHASE3_XOR_RESULT;
+    if (result != expected) {
+        sprintf_s(message, size, "Phase 3 failed: expected %u, got %u", expected, result);
+        return false;
+    }
+    dll.session_magic = result;
+    sprintf_s(message, size, "Full three-phase initialization complete");
+    return true;
+}
+
+// Load the original DLL and give it init_dll_full. With load_dll's single
+// Aud_InitDll(AUD_MAGIC) its file I/O stays locked and every open returns
+// -28 (parity_test.py), so parity, benchmark and soak runs would only time
+// fast failures.
+inline bool load_original_dll(AudDll& dll, const char* dll_path) {
+    if (!load_dll(dll, dll_path, "original", false)) return false;
+    char message[256];
+    if (!init_dll_full(dll, message, sizeof(message))) {
+        fprintf(stderr, "WARNING: original DLL: %s\n", message);
+    }
+    return true;
+}
+
+inline void unload_dll(AudDll& dll) {
+    if (dll.module) {
+        FreeLibrary(dll.module);
+        dll.module = NULL;
+    }
+}
+
+inline bool is_directory(const char* path) {
+    DWORD attrs = GetFileAttributesA(path);
+    return attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+inline unsigned long long file_size_bytes(const wchar_t* path) {
+    HANDLE h = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return 0;
+    LARGE_INTEGER size;
+    size.QuadPart = 0;
+    GetFileSizeEx(h, &size);
+    CloseHandle(h);
+    return (unsigned long long)size.QuadPart;
+}
+
+// ============================================================================
+// Heap allocation tracking
+//
+// The release CRT has no allocation hook (_CrtSetAllocHook is debug-CRT
+// only), and each DLL may link its own CRT, so allocations are counted by
+// patching the tracked DLL's import table: CRT malloc/calloc/realloc/free,
+// operator new/delete and kernel32 HeapAlloc/HeapReAlloc/HeapFree. Only calls
+// made directly by that module are seen; allocations MFC makes on its behalf
+// (CString and friends) land in the MFC DLL's own imports.
+// ============================================================================
+
+struct HeapCounters {
+    long long allocs;       // malloc/calloc/new/HeapAlloc (and realloc of NULL)
+    long long reallocs;
+    long long frees;        // free/delete/HeapFree of a non-NULL pointer
+    long long alloc_bytes;  // Bytes requested by allocs and reallocs
+};
+
+inline HeapCounters heap_counters_delta(const HeapCounters& after, const HeapCounters& before) {
+    HeapCounters d;
+    d.allocs = after.allocs - before.allocs;
+    d.reallocs = after.reallocs - before.reallocs;
+    d.frees = after.frees - before.frees;
+    d.alloc_bytes = after.alloc_bytes - before.alloc_bytes;
+    return d;
+}
+
+#define HEAP_TRACK_SLOTS 2
+#define HEAP_HOOK_MODULES 4     // Import descriptors per DLL with hooked names (msvcrt, ucrtbase, kernel32, ...)
+
+// Live counters per slot
+struct HeapTrackSlot {
+    volatile LONG64 allocs;
+    volatile LONG64 reallocs;
+    volatile LONG64 frees;
+    volatile LONG64 alloc_bytes;
+};
+
+// The real functions the hooks forward to, per slot and per import
+// descriptor: a DLL that takes malloc from both msvcrt and ucrtbase must
+// have each IAT entry forward to its own CRT, or blocks cross heaps.
+struct HeapRealFunctions {
+    void* (__cdecl* real_malloc)(size_t);
+    void* (__cdecl* real_calloc)(size_t, size_t);
+    void* (__cdecl* real_realloc)(void*, size_t);
+    void (__cdecl* real_free)(void*);
+    void* (__cdecl* real_new)(size_t);
+    void* (__cdecl* real_new_array)(size_t);
+    void (__cdecl* real_delete)(void*);
+    void (__cdecl* real_delete_array)(void*);
+    LPVOID (WINAPI* real_heap_alloc)(HANDLE, DWORD, SIZE_T);
+    LPVOID (WINAPI* real_heap_realloc)(HANDLE, DWORD, LPVOID, SIZE_T);
+    BOOL (WINAPI* real_heap_free)(HANDLE, DWORD, LPVOID);
+};
+
+static HeapTrackSlot g_heap_slots[HEAP_TRACK_SLOTS];
+static HeapRealFunctions g_heap_real[HEAP_TRACK_SLOTS][HEAP_HOOK_MODULES];
+
+static inline void heap_count_alloc(HeapTrackSlot& s, size_t bytes) {
+    InterlockedIncrement64(&s.allocs);
+    InterlockedExchangeAdd64(&s.alloc_bytes, (LONG64)bytes);
+}
+
+static inline void heap_count_realloc(HeapTrackSlot& s, void* old, size_t bytes) {
+    if (old) InterlockedIncrement64(&s.reallocs);
+    else InterlockedIncrement64(&s.allocs);
+    InterlockedExchangeAdd64(&s.alloc_bytes, (LONG64)bytes);
+}
+
+static inline void heap_count_free(HeapTrackSlot& s, void* p) {
+    if (p) InterlockedIncrement64(&s.frees);
+}
+
+template <int S, int M> void* __cdecl hook_malloc(size_t n) {
+    heap_count_alloc(g_heap_slots[S], n);
+    return g_heap_real[S][M].real_malloc(n);
+}
+template <int S, int M> void* __cdecl hook_calloc(size_t n, size_t size) {
+    heap_count_alloc(g_heap_slots[S], n * size);
+    return g_heap_real[S][M].real_calloc(n, size);
+}
+template <int S, int M> void* __cdecl hook_realloc(void* p, size_t n) {
+    heap_count_realloc(g_heap_slots[S], p, n);
+    return g_heap_real[S][M].real_realloc(p, n);
+}
+template <int S, int M> void __cdecl hook_free(void* p) {
+    heap_count_free(g_heap_slots[S], p);
+    g_heap_real[S][M].real_free(p);
+}
+template <int S, int M> void* __cdecl hook_new(size_t n) {
+    heap_count_alloc(g_heap_slots[S], n);
+    return g_heap_real[S][M].real_new(n);
+}
+template <int S, int M> void* __cdecl hook_new_array(size_t n) {
+    heap_count_alloc(g_heap_slots[S], n);
+    return g_heap_real[S][M].real_new_array(n);
+}
+template <int S, int M> void __cdecl hook_delete(void* p) {
+    heap_count_free(g_heap_slots[S], p);
+    g_heap_real[S][M].real_delete(p);
+}
+template <int S, int M> void __cdecl hook_delete_array(void* p) {
+    heap_count_free(g_heap_slots[S], p);
+    g_heap_real[S][M].real_delete_array(p);
+}
+template <int S, int M> LPVOID WINAPI hook_heap_alloc(HANDLE heap, DWORD flags, SIZE_T n) {
+    heap_count_alloc(g_heap_slots[S], n);
+    return g_heap_real[S][M].real_heap_alloc(heap, flags, n);
+}
+template <int S, int M> LPVOID WINAPI hook_heap_realloc(HANDLE heap, DWORD flags, LPVOID p, SIZE_T n) {
+    heap_count_realloc(g_heap_slots[S], p, n);
+    return g_heap_real[S][M].real_heap_realloc(heap, flags, p, n);
+}
+template <int S, int M> BOOL WINAPI hook_heap_free(HANDLE heap, DWORD flags, LPVOID p) {
+    heap_count_free(g_heap_slots[S], p);
+    return g_heap_real[S][M].real_heap_free(heap, flags, p);
+}
+
+struct HeapHookEntry {
+    const char* import_name;
+    void* hook;
+    void** real;
+};
+
+#define HEAP_HOOK_NAMES 15
+
+// Import names to patch for slot S, import descriptor M. operator
+// new/delete are listed with both the x86 and x64 decorations.
+template <int S, int M> const HeapHookEntry* heap_hook_table() {
+    HeapRealFunctions& r = g_heap_real[S][M];
+    static const HeapHookEntry table[HEAP_HOOK_NAMES] = {
+        { "malloc", (void*)&hook_malloc<S, M>, (void**)&r.real_malloc },
+        { "calloc", (void*)&hook_calloc<S, M>, (void**)&r.real_calloc },
+        { "realloc", (void*)&hook_realloc<S, M>, (void**)&r.real_realloc },
+        { "free", (void*)&hook_free<S, M>, (void**)&r.real_free },
+        { "??2@YAPAXI@Z", (void*)&hook_new<S, M>, (void**)&r.real_new },
+        { "??2@YAPEAX_K@Z", (void*)&hook_new<S, M>, (void**)&r.real_new },
+        { "??_U@YAPAXI@Z", (void*)&hook_new_array<S, M>, (void**)&r.real_new_array },
+        { "??_U@YAPEAX_K@Z", (void*)&hook_new_array<S, M>, (void**)&r.real_new_array },
+        { "??3@YAXPAX@Z", (void*)&hook_delete<S, M>, (void**)&r.real_delete },
+        { "??3@YAXPEAX@Z", (void*)&hook_delete<S, M>, (void**)&r.real_delete },
+        { "??_V@YAXPAX@Z", (void*)&hook_delete_array<S, M>, (void**)&r.real_delete_array },
+        { "??_V@YAXPEAX@Z", (void*)&hook_delete_array<S, M>, (void**)&r.real_delete_array },
+        { "HeapAlloc", (void*)&hook_heap_alloc<S, M>, (void**)&r.real_heap_alloc },
+        { "HeapReAlloc", (void*)&hook_heap_realloc<S, M>, (void**)&r.real_heap_realloc },
+        { "HeapFree", (void*)&hook_heap_free<S, M>, (void**)&r.real_heap_free },
+    };
+    return table;
+}
+
+template <int S> void heap_hook_tables(const HeapHookEntry* tables[HEAP_HOOK_MODULES]) {
+    tables[0] = heap_hook_table<S, 0>();
+    tables[1] = heap_hook_table<S, 1>();
+    tables[2] = heap_hook_table<S, 2>();
+    tables[3] = heap_hook_table<S, 3>();
+}
+
+// Redirect the module's by-name imports found in the tables. Each import
+// descriptor with a hooked name gets the next table, so its entries keep
+// forwarding to the DLL they were bound to. Returns the number of import
+// slots patched.
+inline int patch_imports(HMODULE module, const HeapHookEntry* const* tables) {
+    BYTE* base = (BYTE*)module;
+    IMAGE_DOS_HEADER* dos = (IMAGE_DOS_HEADER*)base;
+    if (dos->e_magic != IMAGE_DOS_SIGNATURE) return 0;
+    IMAGE_NT_HEADERS* nt = (IMAGE_NT_HEADERS*)(base + dos->e_lfanew);
+    if (nt->Signature != IMAGE_NT_SIGNATURE) return 0;
+    IMAGE_DATA_DIRECTORY dir = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+    if (dir.VirtualAddress == 0) return 0;
+
+    int patched = 0;
+    int modules = 0;
+    for (IMAGE_IMPORT_DESCRIPTOR* imp = (IMAGE_IMPORT_DESCRIPTOR*)(base + dir.VirtualAddress);
+         imp->Name; imp++) {
+        if (!imp->OriginalFirstThunk) continue;  // No name table to match against
+        IMAGE_THUNK_DATA* names = (IMAGE_THUNK_DATA*)(base + imp->OriginalFirstThunk);
+        IMAGE_THUNK_DATA* iat = (IMAGE_THUNK_DATA*)(base + imp->FirstThunk);
+        const HeapHookEntry* table = NULL;
+        for (; names->u1.AddressOfData; names++, iat++) {
+            if (IMAGE_SNAP_BY_ORDINAL(names->u1.Ordinal)) continue;
+            const char* name = ((IMAGE_IMPORT_BY_NAME*)(base + names->u1.AddressOfData))->Name;
+            size_t i = 0;
+            while (i < HEAP_HOOK_NAMES && strcmp(name, tables[0][i].import_name) != 0) i++;
+            if (i == HEAP_HOOK_NAMES) continue;
+            if (!table) {
+                if (modules == HEAP_HOOK_MODULES) {
+                    fprintf(stderr, "WARNING: heap tracking: more than %d allocator DLLs, %s not hooked\n",
+                            HEAP_HOOK_MODULES, (const char*)(base + imp->Name));
+                    break;
+                }
+                table = tables[modules++];
+            }
+            DWORD old_protect;
+            if (!VirtualProtect(&iat->u1.Function, sizeof(iat->u1.Function),
+                                PAGE_READWRITE, &old_protect)) {
+                continue;
+            }
+            *table[i].real = (void*)iat->u1.Function;
+            iat->u1.Function = (ULONG_PTR)table[i].hook;
+            VirtualProtect(&iat->u1.Function, sizeof(iat->u1.Function), old_protect, &old_protect);
+            patched++;
+        }
+    }
+    return patched;
+}
+
+// Start counting heap calls made by the module; slot is 0..HEAP_TRACK_SLOTS-1
+inline int heap_track_install(HMODULE module, int slot) {
+    if (!module) return 0;
+    const HeapHookEntry* tables[HEAP_HOOK_MODULES];
+    if (slot == 0) {
+        heap_hook_tables<0>(tables);
+    } else {
+        heap_hook_tables<1>(tables);
+    }
+    return patch_imports(module, tables);
+}
+
+inline HeapCounters heap_counters(int slot) {
+    HeapCounters c = {};
+    if (slot < 0 || slot >= HEAP_TRACK_SLOTS) return c;
+    const HeapTrackSlot& s = g_heap_slots[slot];
+    c.allocs = s.allocs;
+    c.reallocs = s.reallocs;
+    c.frees = s.frees;
+    c.alloc_bytes = s.alloc_bytes;
+    return c;
+}
+
+// Count the DLL's heap calls from now on (after init, so only file work shows)
+inline void track_heap(AudDll& dll, int slot) {
+    if (!dll.module) return;
+    int patched = heap_track_install(dll.module, slot);
+    dll.heap_slot = slot;
+    fprintf(stderr, "Heap tracking: %s, %d imports hooked\n", dll.dll_name, patched);
+}
+
+// Collect the regular files directly inside dir (sorted for stable output)
+inline bool collect_directory(const char* dir, std::vector<std::string>& files) {
+    std::string pattern = std::string(dir) + "\\*";
+    WIN32_FIND_DATAA fd;
+    HANDLE hFind = FindFirstFileA(pattern.c_str(), &fd);
+    if (hFind == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "ERROR: Cannot list directory: %s (error %lu)\n", dir, GetLastError());
+        return false;
+    }
+    size_t first = files.size();
+    do {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        files.push_back(std::string(dir) + "\\" + fd.cFileName);
+    } while (FindNextFileA(hFind, &fd));
+    FindClose(hFind);
+    std::sort(files.begin() + first, files.end());
+    return true;
+}
+
+// Read a manifest: one path per line, blank lines and '#' comments ignored.
+// Relative paths are relative to the manifest's directory, not the current
+// one, so a manifest can sit next to its corpus. A manifest that lists no
+// files is an error rather than an empty run that passes.
+inline bool collect_manifest(const char* manifest, std::vector<std::string>& files) {
+    FILE* f = NULL;
+    if (fopen_s(&f, manifest, "r") != 0 || !f) {
+        fprintf(stderr, "ERROR: Cannot open manifest: %s\n", manifest);
+        return false;
+    }
+    std::string base(manifest);
+    size_t slash = base.find_last_of("\\/");
+    base = slash == std::string::npos ? std::string() : base.substr(0, slash + 1);
+
+    size_t first = files.size();
+    char line[MAX_PATH + 2];
+    while (fgets(line, sizeof(line), f)) {
+        size_t n = strcspn(line, "\r\n");
+        line[n] = '\0';
+        const char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0' || *p == '#') continue;
+        bool absolute = p[0] == '\\' || p[0] == '/' || (p[0] && p[1] == ':');
+        files.push_back(absolute ? std::string(p) : base + p);
+    }
+    fclose(f);
+    if (files.size() == first) {
+        fprintf(stderr, "ERROR: Manifest lists no files: %s\n", manifest);
+        return false;
+    }
+    return true;
+}
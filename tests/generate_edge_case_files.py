@@ -7,13 +7,25 @@ This script creates audio files that exercise various code paths:
 - Different sample rates (44100, 48000, 96000)
 - Different channel counts (mono, stereo)
 - Edge case values (silence, clipping, DC offset)
+
+With --scaling it instead writes a file-size ladder (1 MB .. 4 GB) of WAV,
+ETM and EFR files into tests/scaling_files/ for mfc_host --scale:
+
+    python generate_edge_case_files.py --scaling
+    python generate_edge_case_files.py --scaling --sizes 1M,64M,1G --channels 1,32
+
+Rungs whose channels exceed 2^26 samples, the most the 32-bit hosts buffer
+(SAMPLE_BUFFER_MAX in aud_host.h), are skipped unless --oversized.
 """
 
+import argparse
+import math
 import struct
 import os
 from pathlib import Path
 
 TEST_FILES_DIR = Path(__file__).parent / "test_files"
+SCALING_FILES_DIR = Path(__file__).parent / "scaling_files"
 
 
 def write_wav(filename: str, samples: list, sample_rate: int = 48000,
@@ -315,5 +327,207 @@ def generate_malformed_files():
     write_wav("edge_4channel.wav", samples, num_channels=4)
 
 
+# ---------------------------------------------------------------------------
+# Scaling ladder
+#
+# Each file is streamed from one precomputed block that holds a whole number
+# of 1 kHz periods, so a 4 GB file costs one block of Python work and the
+# rest is f.write(). Channel k carries amplitude 0.9 / (k + 1) so a channel
+# ordering bug shows up as a sample mismatch rather than passing silently.
+# ---------------------------------------------------------------------------
+
+SCALING_SAMPLE_RATE = 96000
+SCALING_BLOCK_FRAMES = 9600  # 100 ms = 100 periods of 1 kHz at 96 kHz
+
+# name -> (bits_per_sample, wav audio_format)
+SCALING_SAMPLE_TYPES = {
+    "8bit": (8, 1),
+    "16bit": (16, 1),
+    "24bit": (24, 1),
+    "32bit": (32, 1),
+    "f32": (32, 3),
+    "f64": (64, 3),
+}
+
+# RIFF sizes are 32-bit: the data chunk must leave room for the 36-byte
+# header before the RIFF size field overflows.
+WAV_MAX_DATA_BYTES = 0xFFFFFFFF - 36
+
+# Easera templates: the 256-byte header and the trailing metadata block are
+# kept, the sample payload is tiled from the template to the target length.
+# Layout inferred from the fixtures (not from a spec):
+#   0x14 u32  stored values (ETM: samples, EFR: FFT bins = length / 2 + 1)
+#   0x18 u32  time-domain length
+#   0x24 u32  1 = real float64, 2 = complex float64 pairs
+#   0x100     payload
+#   trailer   "Easera  " + copy of 0x14/0x18 at trailer offsets 8/12
+EASERA_TEMPLATES = {
+    "etm": "IR000040.etm",
+    "efr": "test.efr",
+}
+EASERA_DATA_OFFSET = 0x100
+
+# SAMPLE_BUFFER_MAX in aud_host.h: the 32-bit hosts refuse channels longer
+# than this, so larger rungs of the ladder are skipped unless --oversized.
+HOST_MAX_CHANNEL_SAMPLES = 1 << 26
+
+
+def parse_size(text: str) -> int:
+    """Parse '1M', '512K', '4G' or a plain byte count."""
+    text = text.strip().upper()
+    scale = {"K": 1 << 10, "M": 1 << 20, "G": 1 << 30}.get(text[-1:], 1)
+    if scale != 1:
+        text = text[:-1]
+    return int(float(text) * scale)
+
+
+def format_size(size: int) -> str:
+    for suffix, scale in (("G", 1 << 30), ("M", 1 << 20), ("K", 1 << 10)):
+        if size >= scale and size % scale == 0:
+            return f"{size // scale}{suffix}"
+    return str(size)
+
+
+def scaling_block(bits_per_sample: int, audio_format: int, num_channels: int) -> bytes:
+    """One interleaved block of SCALING_BLOCK_FRAMES frames."""
+    frames = []
+    for i in range(SCALING_BLOCK_FRAMES):
+        phase = math.sin(2 * math.pi * 1000.0 * i / SCALING_SAMPLE_RATE)
+        for ch in range(num_channels):
+            sample = phase * 0.9 / (ch + 1)
+            if audio_format == 3:
+                frames.append(struct.pack("<f" if bits_per_sample == 32 else "<d", sample))
+            elif bits_per_sample == 8:
+                frames.append(struct.pack("B", int(sample * 127 + 128)))
+            elif bits_per_sample == 16:
+                frames.append(struct.pack("<h", int(sample * 32767)))
+            elif bits_per_sample == 24:
+                frames.append(struct.pack("<i", int(sample * 8388607))[:3])
+            else:
+                frames.append(struct.pack("<i", int(sample * 2147483647)))
+    return b"".join(frames)
+
+
+def write_wav_scaled(filepath: Path, target_bytes: int, bits_per_sample: int,
+                     audio_format: int, num_channels: int):
+    """Stream a WAV of roughly target_bytes, clamped to the RIFF limit."""
+    block = scaling_block(bits_per_sample, audio_format, num_channels)
+    block_align = num_channels * bits_per_sample // 8
+    data_size = min(max(target_bytes - 44, block_align), WAV_MAX_DATA_BYTES)
+    data_size -= data_size % block_align
+
+    with open(filepath, "wb") as f:
+        f.write(b"RIFF" + struct.pack("<I", 36 + data_size) + b"WAVE")
+        f.write(b"fmt " + struct.pack("<I", 16))
+        f.write(struct.pack("<HHIIHH", audio_format, num_channels, SCALING_SAMPLE_RATE,
+                            SCALING_SAMPLE_RATE * block_align, block_align, bits_per_sample))
+        f.write(b"data" + struct.pack("<I", data_size))
+
+        remaining = data_size
+        while remaining >= len(block):
+            f.write(block)
+            remaining -= len(block)
+        f.write(block[:remaining])
+
+    return data_size // block_align
+
+
+def write_easera_scaled(filepath: Path, kind: str, target_bytes: int):
+    """Stretch an ETM/EFR fixture to roughly target_bytes."""
+    data = (TEST_FILES_DIR / EASERA_TEMPLATES[kind]).read_bytes()
+    stored, length, value_type = struct.unpack_from("<II", data, 0x14) + \
+        struct.unpack_from("<I", data, 0x24)
+    value_size = 16 if value_type == 2 else 8
+    payload = data[EASERA_DATA_OFFSET:EASERA_DATA_OFFSET + stored * value_size]
+    trailer = bytearray(data[EASERA_DATA_OFFSET + stored * value_size:])
+
+    budget = max(target_bytes - EASERA_DATA_OFFSET - len(trailer), value_size) // value_size
+    if kind == "efr":
+        # Keep the FFT relationship: a power-of-two length, length / 2 + 1 bins.
+        new_length = 1 << max(1, int(math.log2(max(2, (budget - 1) * 2))))
+        new_stored = new_length // 2 + 1
+    else:
+        new_length = new_stored = budget
+
+    header = bytearray(data[:EASERA_DATA_OFFSET])
+    struct.pack_into("<II", header, 0x14, new_stored, new_length)
+    if trailer[:8] == b"Easera  ":
+        struct.pack_into("<II", trailer, 8, new_stored, new_length)
+
+    with open(filepath, "wb") as f:
+        f.write(header)
+        remaining = new_stored * value_size
+        while remaining >= len(payload):
+            f.write(payload)
+            remaining -= len(payload)
+        f.write(payload[:remaining])
+        f.write(trailer)
+
+    return new_stored
+
+
+def generate_scaling_files(args):
+    print("=" * 60)
+    print("Generating Scaling Files")
+    print("=" * 60)
+
+    out_dir = Path(args.out)
+    os.makedirs(out_dir, exist_ok=True)
+    sizes = [parse_size(s) for s in args.sizes.split(",")]
+    channels = [int(c) for c in args.channels.split(",")]
+    types = args.types.split(",")
+
+    def oversized(filename, samples):
+        if samples <= HOST_MAX_CHANNEL_SAMPLES or args.oversized:
+            return False
+        print(f"[SKIP] {filename}: ~{samples} samples per channel, over the hosts' "
+              f"{HOST_MAX_CHANNEL_SAMPLES}-sample limit (--oversized writes it anyway)")
+        return True
+
+    for size in sizes:
+        for name in types:
+            if name in EASERA_TEMPLATES:
+                filename = f"scale_{name}_{format_size(size)}.{name}"
+                if oversized(filename, size // 8):
+                    continue
+                count = write_easera_scaled(out_dir / filename, name, size)
+                print(f"[OK] Generated: {filename} ({count} values)")
+                continue
+            bits, audio_format = SCALING_SAMPLE_TYPES[name]
+            for num_channels in channels:
+                filename = f"scale_{name}_{num_channels}ch_{format_size(size)}.wav"
+                block_align = num_channels * bits // 8
+                if oversized(filename, min(size, WAV_MAX_DATA_BYTES) // block_align):
+                    continue
+                frames = write_wav_scaled(out_dir / filename, size, bits,
+                                          audio_format, num_channels)
+                print(f"[OK] Generated: {filename} ({frames} frames)")
+
+    total = sum(f.stat().st_size for f in out_dir.glob("scale_*"))
+    print(f"\n{len(list(out_dir.glob('scale_*')))} files, {total / (1 << 20):.1f} MB in {out_dir}")
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="Generate edge case and scaling test files")
+    parser.add_argument("--scaling", action="store_true",
+                        help="write the file-size ladder instead of the edge case fixtures")
+    parser.add_argument("--sizes", default="1M,4M,16M,64M,256M",
+                        help="comma-separated target sizes, K/M/G suffixes (4G is clamped "
+                             "to the RIFF limit for WAV)")
+    parser.add_argument("--types", default=",".join(list(SCALING_SAMPLE_TYPES) + list(EASERA_TEMPLATES)),
+                        help="comma-separated: 8bit,16bit,24bit,32bit,f32,f64,etm,efr")
+    parser.add_argument("--channels", default="1,2,8,32",
+                        help="comma-separated WAV channel counts")
+    parser.add_argument("--oversized", action="store_true",
+                        help="also write files with channels over the 32-bit hosts' 2^26-sample limit")
+    parser.add_argument("--out", default=str(SCALING_FILES_DIR),
+                        help="output directory for --scaling")
+    return parser.parse_args()
+
+
 if __name__ == "__main__":
-    main()
+    args = parse_args()
+    if args.scaling:
+        generate_scaling_files(args)
+    else:
+        main()
@@ -0,0 +1,704 @@
+/*
+ * Read-path Throughput Benchmark for target.dll
+ *
+ * Repeatedly opens and decodes every test file with both the original and
+ * the rebuilt DLL and reports per-format throughput, so parser regressions in
+ * the rebuilt DLL show up before a release. One iteration is the full client
+ * sequence: Aud_OpenGetFile, every channel of every file through
+ * Aud_GetChannelDataDoubles (size query + read), Aud_CloseGetFile.
+ *
+ * Two cache modes are measured:
+ *   warm - one untimed warm-up pass, then N timed iterations
+ *   cold - the file's cached pages are purged before every iteration
+ *          (best effort: the file is reopened with FILE_FLAG_NO_BUFFERING,
+ *          which makes the cache manager flush and purge it; no admin needed)
+ *
+ * Two more modes time the metadata-only sequence analysis tools repeat on
+ * the same files: Aud_OpenGetFile, Aud_GetFileProperties and
+ * Aud_GetChannelProperties for every channel, Aud_CloseGetFile, no samples:
+ *   meta_cold - the file's cached pages are purged before every iteration
+ *   meta_hot  - the pages stay cached, so only header parsing is timed
+ * Every iteration's property blocks are hashed and must match the warm-up
+ * pass; differences are counted in props_mismatches and make the run exit
+ * non-zero.
+ *
+ * Iterations alternate between the two DLLs so clock and thermal drift hit
+ * both equally. The thread is pinned to one CPU and runs at high priority.
+ * Results are one JSON record per (file, dll, cache mode) with min / median /
+ * p95 / p99 iteration time plus samples/sec and MB/s at the median, and a
+ * per-format rebuilt-vs-original summary on stderr.
+ *
+ * Build with Visual Studio Developer Command Prompt:
+ *   cl /EHsc /MD /O2 /D_AFXDLL mfc_bench.cpp /link /SUBSYSTEM:CONSOLE mfc140.lib
+ *
+ * Usage:
+ *   mfc_bench [options] <original_dll> <rebuilt_dll> <test_file | test_dir | @manifest>
+ *
+ * Options:
+ *   --iterations N      Timed iterations per file and DLL (default 50)
+ *   --cpu K             Pin to logical CPU K (default 0, -1 = no pinning)
+ *   --cache MODE        warm, cold, both (default), meta or all
+ *   --format CODE       Only benchmark files with this format code
+ *   --profile DIR       Sample call stacks per format instead (see below)
+ *   --profile-ms N      Sampling time per format and DLL (default 2000)
+ *
+ * --profile decodes each format's files in a loop, one DLL at a time, while
+ * sampling the decoding thread's call stack at about 1 kHz, and writes one
+ * folded-stack file per (format, DLL) to DIR plus a JSON index on stdout.
+ * profile_report.py turns them into flame graphs and hot-spot tables,
+ * original vs rebuilt.
+ */
+
+// Force MFC to be included
+#define _AFXDLL
+#include <afx.h>
+#include <afxwin.h>
+
+#include <windows.h>
+#include <mmsystem.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "aud_host.h"
+
+#pragma comment(lib, "winmm.lib")
+
+// Minimal MFC application class
+class CTestApp : public CWinApp {
+public:
+    virtual BOOL InitInstance() {
+        return TRUE;
+    }
+};
+
+// Global MFC app instance
+CTestApp theApp;
+
+enum CacheMode { CACHE_WARM, CACHE_COLD, CACHE_META_COLD, CACHE_META_HOT, CACHE_MODES };
+
+static const char* const g_cache_names[] = { "warm", "cold", "meta_cold", "meta_hot" };
+
+const char* format_name(int code) {
+    switch (code) {
+    case 1:  return "AudioMeasureEtm";
+    case 2:  return "AudioMeasureEfr";
+    case 3:  return "AudioMeasureEmd";
+    case 5:  return "AudioMeasureEtx";
+    case 9:  return "MsWave";
+    case 10: return "MlssaTim";
+    case 11: return "MlssaFrq";
+    case 12: return "MonkeyForestDat";
+    case 13: return "MonkeyForestSpk";
+    case 24: return "ClioFreqText";
+    default: return "AutoDetect";
+    }
+}
+
+struct BenchOptions {
+    int iterations;
+    int cpu;
+    bool warm;
+    bool cold;
+    bool meta;              // meta_cold and meta_hot
+    int format_filter;      // -1 = all formats
+    const char* profile_dir;        // --profile: write folded stacks here instead of benchmarking
+    unsigned int profile_ms;        // Sampling time per format and DLL
+};
+
+// Timed iterations of one DLL on one file in one cache mode
+struct BenchSeries {
+    int open_ret;
+    unsigned long long samples;     // Samples decoded per iteration
+    unsigned long long props_hash;  // Metadata modes: property blocks of the warm-up pass
+    unsigned int props_mismatches;  // Iterations whose property blocks differed
+    std::vector<double> times_ms;
+};
+
+struct BenchStats {
+    double min_ms;
+    double median_ms;
+    double p95_ms;
+    double p99_ms;
+};
+
+// Nearest-rank percentile of an ascending-sorted series
+double percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)(q * (double)sorted.size() + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > sorted.size()) rank = sorted.size();
+    return sorted[rank - 1];
+}
+
+BenchStats compute_stats(const std::vector<double>& times_ms) {
+    std::vector<double> sorted(times_ms);
+    std::sort(sorted.begin(), sorted.end());
+    BenchStats st;
+    st.min_ms = sorted.empty() ? 0.0 : sorted[0];
+    st.median_ms = percentile(sorted, 0.50);
+    st.p95_ms = percentile(sorted, 0.95);
+    st.p99_ms = percentile(sorted, 0.99);
+    return st;
+}
+
+// Purge the file from the system cache (see header comment)
+void evict_file_cache(const wchar_t* path) {
+    HANDLE h = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                           OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+    if (h != INVALID_HANDLE_VALUE) CloseHandle(h);
+}
+
+// One full open -> read all channels -> close cycle. Returns Aud_OpenGetFile's
+// result; elapsed time and decoded sample count are returned through the
+// out parameters.
+int decode_once(const AudDll& dll, const wchar_t* path, int format_code, SampleBuffer& buf,
+                double& elapsed_ms, unsigned long long& samples) {
+    samples = 0;
+    LONGLONG t0 = timer_now();
+    int ret = dll.Aud_OpenGetFile(path, format_code, 0);
+    if (ret == 0) {
+        unsigned int files_count = 1;
+        if (dll.Aud_GetNumberOfFiles) dll.Aud_GetNumberOfFiles(&files_count);
+        for (unsigned int f = 0; f < files_count; f++) {
+            unsigned int channels_count = 0;
+            if (dll.Aud_GetNumberOfChannels) dll.Aud_GetNumberOfChannels(f, &channels_count);
+            for (unsigned int c = 0; c < channels_count && dll.Aud_GetChannelDataDoubles; c++) {
+                unsigned int count = 0;
+                if (dll.Aud_GetChannelDataDoubles(f, c, NULL, &count) == 0 && count > 0 &&
+                    buffer_reserve(buf, count) &&
+                    dll.Aud_GetChannelDataDoubles(f, c, buf.data, &count) == 0) {
+                    samples += count;
+                }
+            }
+        }
+        if (dll.Aud_CloseGetFile) dll.Aud_CloseGetFile();
+    }
+    elapsed_ms = timer_ms(t0, timer_now());
+    return ret;
+}
+
+static void hash_props(unsigned long long& h, int ret, const unsigned char* props) {
+    h = (h ^ (unsigned int)ret) * 1099511628211ULL;
+    for (size_t i = 0; i < AUD_PROPS_SIZE; i++) h = (h ^ props[i]) * 1099511628211ULL;
+}
+
+// One metadata-only open -> properties of every file and channel -> close
+// cycle. Returns Aud_OpenGetFile's result; the property blocks are hashed
+// into props_hash.
+int metadata_once(const AudDll& dll, const wchar_t* path, int format_code, double& elapsed_ms,
+                  unsigned long long& props_hash) {
+    unsigned char props[AUD_PROPS_SIZE];
+    props_hash = 14695981039346656037ULL;
+    LONGLONG t0 = timer_now();
+    int ret = dll.Aud_OpenGetFile(path, format_code, 0);
+    if (ret == 0) {
+        unsigned int files_count = 1;
+        if (dll.Aud_GetNumberOfFiles) dll.Aud_GetNumberOfFiles(&files_count);
+        for (unsigned int f = 0; f < files_count; f++) {
+            if (dll.Aud_GetFileProperties) {
+                memset(props, 0, sizeof(props));
+                hash_props(props_hash, dll.Aud_GetFileProperties(f, props), props);
+            }
+            unsigned int channels_count = 0;
+            if (dll.Aud_GetNumberOfChannels) dll.Aud_GetNumberOfChannels(f, &channels_count);
+            for (unsigned int c = 0; c < channels_count && dll.Aud_GetChannelProperties; c++) {
+                memset(props, 0, sizeof(props));
+                hash_props(props_hash, dll.Aud_GetChannelProperties(f, c, props), props);
+            }
+        }
+        if (dll.Aud_CloseGetFile) dll.Aud_CloseGetFile();
+    }
+    elapsed_ms = timer_ms(t0, timer_now());
+    return ret;
+}
+
+// Run both DLLs on one file, alternating per iteration
+void bench_file(AudDll* dlls, BenchSeries* series, const wchar_t* path, int format_code,
+                CacheMode mode, const BenchOptions& opts, SampleBuffer& buf) {
+    bool meta = mode == CACHE_META_COLD || mode == CACHE_META_HOT;
+    for (int d = 0; d < 2; d++) {
+        series[d].open_ret = -999;   // Sentinel for "not tested"
+        series[d].samples = 0;
+        series[d].props_hash = 0;
+        series[d].props_mismatches = 0;
+        series[d].times_ms.clear();
+        if (!dlls[d].module) continue;
+
+        // Warm-up pass also tells us whether this DLL can open the file at all
+        double ms;
+        if (meta) {
+            series[d].open_ret = metadata_once(dlls[d], path, format_code, ms, series[d].props_hash);
+        } else {
+            series[d].open_ret = decode_once(dlls[d], path, format_code, buf, ms, series[d].samples);
+        }
+    }
+
+    for (int it = 0; it < opts.iterations; it++) {
+        for (int d = 0; d < 2; d++) {
+            if (series[d].open_ret != 0) continue;
+            double ms;
+            if (meta) {
+                if (mode == CACHE_META_COLD) evict_file_cache(path);
+                unsigned long long props_hash;
+                if (metadata_once(dlls[d], path, format_code, ms, props_hash) == 0) {
+                    series[d].times_ms.push_back(ms);
+                    if (props_hash != series[d].props_hash) series[d].props_mismatches++;
+                }
+                continue;
+            }
+            if (mode == CACHE_COLD) evict_file_cache(path);
+            unsigned long long samples;
+            if (decode_once(dlls[d], path, format_code, buf, ms, samples) == 0) {
+                series[d].times_ms.push_back(ms);
+            }
+        }
+    }
+}
+
+struct FormatTotals {
+    double median_ms[2];
+    unsigned int files;
+};
+
+void print_record(bool first, const AudDll& dll, const char* file, int format_code,
+                  CacheMode mode, unsigned long long bytes, const BenchSeries& s) {
+    BenchStats st = compute_stats(s.times_ms);
+    double seconds = st.median_ms / 1000.0;
+    double samples_per_sec = seconds > 0.0 ? (double)s.samples / seconds : 0.0;
+    double mb_per_sec = seconds > 0.0 ? (double)bytes / (1024.0 * 1024.0) / seconds : 0.0;
+
+    if (!first) printf(",\n");
+    printf("  {\n");
+    printf("    \"dll\": \"%s\",\n", dll.dll_name);
+    printf("    \"file\": ");
+    print_json_string(file);
+    printf(",\n");
+    printf("    \"format\": %d,\n", format_code);
+    printf("    \"format_name\": \"%s\",\n", format_name(format_code));
+    printf("    \"cache\": \"%s\",\n", g_cache_names[mode]);
+    printf("    \"open_ret\": %d,\n", s.open_ret);
+    printf("    \"iterations\": %u,\n", (unsigned)s.times_ms.size());
+    printf("    \"bytes\": %llu,\n", bytes);
+    printf("    \"samples\": %llu,\n", s.samples);
+    printf("    \"props_mismatches\": %u,\n", s.props_mismatches);
+    printf("    \"min_ms\": %.4f,\n", st.min_ms);
+    printf("    \"median_ms\": %.4f,\n", st.median_ms);
+    printf("    \"p95_ms\": %.4f,\n", st.p95_ms);
+    printf("    \"p99_ms\": %.4f,\n", st.p99_ms);
+    printf("    \"samples_per_sec\": %.1f,\n", samples_per_sec);
+    printf("    \"mb_per_sec\": %.3f\n", mb_per_sec);
+    printf("  }");
+}
+
+// ============================================================================
+// Sampling profiler (--profile DIR)
+//
+// Each format's files are decoded in a loop on a worker thread, one DLL at a
+// time, for --profile-ms; this thread suspends the worker every millisecond,
+// reads its instruction pointer and walks the frame-pointer chain, and
+// resumes it. Stacks are written per (format, DLL) in folded form, root
+// first, one "frame;frame;...;leaf count" line per distinct stack, with
+// frames as <module>+0x<rva> and the two target.dll copies named original
+// and rebuilt. profile_report.py symbolizes them against the DLLs' exports
+// (or a symbol map) and draws flame graphs and hot-spot tables side by side.
+//
+// The leaf frame is exact; callers are only as good as the frame-pointer
+// chain, so functions built without EBP frames drop out of the middle of a
+// stack. Nothing is allocated while the worker is suspended, since it may be
+// holding the heap lock.
+// ============================================================================
+
+#define PROFILE_MAX_FRAMES 64
+
+struct ProfileJob {
+    const AudDll* dll;
+    const std::vector<std::wstring>* files;
+    int format_code;
+    volatile LONG stop;
+    unsigned int iterations;        // Passes over the format's files
+    unsigned long long samples;     // Audio samples decoded
+    SampleBuffer buf;
+};
+
+static DWORD WINAPI profile_worker(LPVOID param) {
+    ProfileJob* job = (ProfileJob*)param;
+    while (!job->stop) {
+        for (size_t i = 0; i < job->files->size() && !job->stop; i++) {
+            double ms;
+            unsigned long long samples;
+            if (decode_once(*job->dll, (*job->files)[i].c_str(), job->format_code, job->buf,
+                            ms, samples) == 0) {
+                job->samples += samples;
+            }
+        }
+        job->iterations++;
+    }
+    return 0;
+}
+
+// Instruction pointer plus the return addresses of the frame-pointer chain
+static unsigned int walk_stack(const CONTEXT& ctx, DWORD_PTR* frames, unsigned int max) {
+#if defined(_M_IX86)
+    DWORD_PTR pc = ctx.Eip, fp = ctx.Ebp;
+#else
+    DWORD_PTR pc = ctx.Rip, fp = ctx.Rbp;
+#endif
+    unsigned int n = 0;
+    frames[n++] = pc;
+    while (n < max && fp) {
+        DWORD_PTR link[2];      // Saved frame pointer, return address
+        SIZE_T got = 0;
+        if (!ReadProcessMemory(GetCurrentProcess(), (const void*)fp, link, sizeof(link), &got) ||
+            got != sizeof(link) || link[0] <= fp || link[1] == 0) {
+            break;
+        }
+        frames[n++] = link[1];
+        fp = link[0];
+    }
+    return n;
+}
+
+struct ProfileSymbols {
+    const AudDll* dlls;
+    std::map<HMODULE, std::string> modules;
+};
+
+static std::string frame_label(ProfileSymbols& sym, DWORD_PTR pc) {
+    HMODULE module = NULL;
+    if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                            GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                            (LPCSTR)pc, &module) || !module) {
+        return "?";
+    }
+    std::map<HMODULE, std::string>::iterator it = sym.modules.find(module);
+    if (it == sym.modules.end()) {
+        std::string name;
+        if (module == sym.dlls[0].module) {
+            name = sym.dlls[0].dll_name;
+        } else if (module == sym.dlls[1].module) {
+            name = sym.dlls[1].dll_name;
+        } else {
+            char path[MAX_PATH] = "?";
+            GetModuleFileNameA(module, path, MAX_PATH);
+            const char* base = strrchr(path, '\\');
+            name = base ? base + 1 : path;
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        }
+        it = sym.modules.insert(std::make_pair(module, name)).first;
+    }
+    char label[32];
+    sprintf_s(label, sizeof(label), "+0x%lx", (unsigned long)(pc - (DWORD_PTR)module));
+    return it->second + label;
+}
+
+struct ProfileResult {
+    unsigned int stacks;            // Samples taken
+    unsigned int in_dll;            // Samples whose leaf is inside the profiled DLL
+    unsigned long long frames;      // Sum of stack depths
+    double duration_ms;
+    std::map<std::string, unsigned int> folded;
+};
+
+ProfileResult profile_format(const AudDll* dlls, int d, const std::vector<std::wstring>& files,
+                             int format_code, unsigned int duration_ms) {
+    ProfileResult r = {};
+    ProfileJob job = {};
+    job.dll = &dlls[d];
+    job.files = &files;
+    job.format_code = format_code;
+    job.buf.data = NULL;
+    job.buf.capacity = 0;
+
+    HANDLE worker = CreateThread(NULL, 0, profile_worker, &job, 0, NULL);
+    if (!worker) return r;
+    ProfileSymbols sym = { dlls };
+    DWORD_PTR frames[PROFILE_MAX_FRAMES];
+    LONGLONG t0 = timer_now();
+    while (timer_ms(t0, timer_now()) < duration_ms) {
+        Sleep(1);
+        if (SuspendThread(worker) == (DWORD)-1) break;
+        CONTEXT ctx;
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.ContextFlags = CONTEXT_CONTROL | CONTEXT_INTEGER;
+        unsigned int n = GetThreadContext(worker, &ctx) ? walk_stack(ctx, frames, PROFILE_MAX_FRAMES) : 0;
+        ResumeThread(worker);
+        if (n == 0) continue;
+
+        std::string stack;
+        for (unsigned int i = n; i-- > 0;) {
+            stack += frame_label(sym, frames[i]);
+            if (i > 0) stack += ';';
+        }
+        r.folded[stack]++;
+        r.stacks++;
+        r.frames += n;
+        HMODULE leaf = NULL;
+        if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                               GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                               (LPCSTR)frames[0], &leaf) && leaf == dlls[d].module) {
+            r.in_dll++;
+        }
+    }
+    job.stop = 1;
+    WaitForSingleObject(worker, INFINITE);
+    CloseHandle(worker);
+    r.duration_ms = timer_ms(t0, timer_now());
+    buffer_free(job.buf);
+
+    fprintf(stderr, "  %-9s %6u samples, %5.1f%% in DLL, %u passes, %llu audio samples\n",
+            dlls[d].dll_name, r.stacks, r.stacks ? 100.0 * r.in_dll / r.stacks : 0.0,
+            job.iterations, job.samples);
+    return r;
+}
+
+int run_profile(const AudDll* dlls, const std::vector<std::string>& test_files,
+                const BenchOptions& opts) {
+    std::map<int, std::vector<std::wstring> > by_format;
+    for (size_t i = 0; i < test_files.size(); i++) {
+        char abs_path[MAX_PATH];
+        GetFullPathNameA(test_files[i].c_str(), MAX_PATH, abs_path, NULL);
+        wchar_t abs_path_w[MAX_PATH];
+        MultiByteToWideChar(CP_UTF8, 0, abs_path, -1, abs_path_w, MAX_PATH);
+        int format_code = get_format_code(abs_path_w);
+        if (opts.format_filter >= 0 && format_code != opts.format_filter) continue;
+        by_format[format_code].push_back(abs_path_w);
+    }
+
+    CreateDirectoryA(opts.profile_dir, NULL);
+    timeBeginPeriod(1);
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+
+    bool first = true;
+    printf("[\n");
+    for (std::map<int, std::vector<std::wstring> >::const_iterator it = by_format.begin();
+         it != by_format.end(); ++it) {
+        fprintf(stderr, "Profiling: format %d (%s), %u files, %u ms per DLL\n", it->first,
+                format_name(it->first), (unsigned)it->second.size(), opts.profile_ms);
+        for (int d = 0; d < 2; d++) {
+            if (!dlls[d].module) continue;
+            ProfileResult r = profile_format(dlls, d, it->second, it->first, opts.profile_ms);
+
+            char folded_path[MAX_PATH];
+            sprintf_s(folded_path, sizeof(folded_path), "%s\\%s_%s.folded", opts.profile_dir,
+                      format_name(it->first), dlls[d].dll_name);
+            FILE* out = NULL;
+            if (fopen_s(&out, folded_path, "w") == 0 && out) {
+                for (std::map<std::string, unsigned int>::const_iterator s = r.folded.begin();
+                     s != r.folded.end(); ++s) {
+                    fprintf(out, "%s %u\n", s->first.c_str(), s->second);
+                }
+                fclose(out);
+            } else {
+                fprintf(stderr, "ERROR: Cannot write %s\n", folded_path);
+            }
+
+            if (!first) printf(",\n");
+            first = false;
+            printf("  {\"dll\": \"%s\", \"format\": %d, \"format_name\": \"%s\", \"files\": %u, "
+                   "\"duration_ms\": %.1f, \"stacks\": %u, \"in_dll\": %u, \"mean_depth\": %.2f, "
+                   "\"distinct_stacks\": %u, \"folded\": ",
+                   dlls[d].dll_name, it->first, format_name(it->first), (unsigned)it->second.size(),
+                   r.duration_ms, r.stacks, r.in_dll, r.stacks ? (double)r.frames / r.stacks : 0.0,
+                   (unsigned)r.folded.size());
+            print_json_string(folded_path);
+            printf("}");
+            fflush(stdout);
+        }
+    }
+    printf("\n]\n");
+    timeEndPeriod(1);
+    return 0;
+}
+
+void print_usage(const char* exe) {
+    fprintf(stderr, "Usage: %s [options] <original_dll> <rebuilt_dll> <test_file | test_dir | @manifest>\n", exe);
+    fprintf(stderr, "\nBenchmarks target.dll read throughput per format for both DLLs.\n");
+    fprintf(stderr, "\nOptions:\n");
+    fprintf(stderr, "  --iterations N    Timed iterations per file and DLL (default 50)\n");
+    fprintf(stderr, "  --cpu K           Pin to logical CPU K (default 0, -1 = no pinning)\n");
+    fprintf(stderr, "  --cache MODE      warm, cold, both (default), meta (metadata-only opens,\n");
+    fprintf(stderr, "                    page cache cold and hot) or all\n");
+    fprintf(stderr, "  --format CODE     Only benchmark files with this format code\n");
+    fprintf(stderr, "  --profile DIR     Sample call stacks per format instead of benchmarking;\n");
+    fprintf(stderr, "                    folded stacks go to DIR (see profile_report.py)\n");
+    fprintf(stderr, "  --profile-ms N    Sampling time per format and DLL (default 2000)\n");
+}
+
+int main(int argc, char* argv[]) {
+    // Initialize MFC
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        fprintf(stderr, "ERROR: MFC initialization failed\n");
+        return 1;
+    }
+
+    timer_init();
+
+    BenchOptions opts;
+    opts.iterations = 50;
+    opts.cpu = 0;
+    opts.warm = true;
+    opts.cold = true;
+    opts.meta = false;
+    opts.format_filter = -1;
+    opts.profile_dir = NULL;
+    opts.profile_ms = 2000;
+
+    int argi = 1;
+    while (argi < argc && strncmp(argv[argi], "--", 2) == 0) {
+        const char* opt = argv[argi++];
+        if (argi >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        const char* val = argv[argi++];
+        if (strcmp(opt, "--iterations") == 0) {
+            opts.iterations = atoi(val);
+            if (opts.iterations < 1) opts.iterations = 1;
+        } else if (strcmp(opt, "--cpu") == 0) {
+            opts.cpu = atoi(val);
+        } else if (strcmp(opt, "--cache") == 0) {
+            bool all = strcmp(val, "all") == 0;
+            opts.meta = all || strcmp(val, "meta") == 0;
+            opts.warm = all || strcmp(val, "both") == 0 || strcmp(val, "warm") == 0;
+            opts.cold = all || strcmp(val, "both") == 0 || strcmp(val, "cold") == 0;
+            if (!opts.meta && !opts.warm && !opts.cold) {
+                fprintf(stderr, "ERROR: --cache expects warm, cold, both, meta or all, got %s\n", val);
+                return 1;
+            }
+        } else if (strcmp(opt, "--profile") == 0) {
+            opts.profile_dir = val;
+        } else if (strcmp(opt, "--profile-ms") == 0) {
+            opts.profile_ms = (unsigned int)atoi(val);
+        } else if (strcmp(opt, "--format") == 0) {
+            opts.format_filter = atoi(val);
+        } else {
+            fprintf(stderr, "ERROR: Unknown option: %s\n", opt);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - argi < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const char* original_dll = argv[argi];
+    const char* rebuilt_dll = argv[argi + 1];
+    const char* target = argv[argi + 2];
+
+    std::vector<std::string> test_files;
+    if (target[0] == '@') {
+        if (!collect_manifest(target + 1, test_files)) return 1;
+    } else if (is_directory(target)) {
+        if (!collect_directory(target, test_files)) return 1;
+    } else {
+        test_files.push_back(target);
+    }
+
+    // Pin and prioritize so iterations are comparable
+    if (opts.cpu >= 0) {
+        if (!SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << opts.cpu)) {
+            fprintf(stderr, "WARNING: Could not pin to CPU %d (error %lu)\n", opts.cpu, GetLastError());
+        }
+    }
+    SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS);
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+
+    fprintf(stderr, "Original DLL: %s\n", original_dll);
+    fprintf(stderr, "Rebuilt DLL: %s\n", rebuilt_dll);
+    fprintf(stderr, "Files: %u, iterations: %d, cpu: %d\n",
+            (unsigned)test_files.size(), opts.iterations, opts.cpu);
+
+    AudDll dlls[2];
+    load_original_dll(dlls[0], original_dll);
+    load_dll(dlls[1], rebuilt_dll, "rebuilt");
+
+    if (opts.profile_dir) {
+        int ret = run_profile(dlls, test_files, opts);
+        unload_dll(dlls[0]);
+        unload_dll(dlls[1]);
+        return ret;
+    }
+
+    SampleBuffer buf = { NULL, 0 };
+    std::map<int, FormatTotals> totals[CACHE_MODES];     // Per cache mode, keyed by format code
+    bool first = true;
+    unsigned int meta_failures = 0;
+
+    printf("[\n");
+
+    for (size_t i = 0; i < test_files.size(); i++) {
+        char abs_path[MAX_PATH];
+        GetFullPathNameA(test_files[i].c_str(), MAX_PATH, abs_path, NULL);
+        wchar_t abs_path_w[MAX_PATH];
+        MultiByteToWideChar(CP_UTF8, 0, abs_path, -1, abs_path_w, MAX_PATH);
+
+        int format_code = get_format_code(abs_path_w);
+        if (opts.format_filter >= 0 && format_code != opts.format_filter) continue;
+
+        unsigned long long bytes = file_size_bytes(abs_path_w);
+        fprintf(stderr, "Benchmarking: %s (format %d, %llu bytes)\n", abs_path, format_code, bytes);
+
+        for (int m = CACHE_WARM; m < CACHE_MODES; m++) {
+            CacheMode mode = (CacheMode)m;
+            if ((mode == CACHE_WARM && !opts.warm) || (mode == CACHE_COLD && !opts.cold)) continue;
+            if ((mode == CACHE_META_COLD || mode == CACHE_META_HOT) && !opts.meta) continue;
+
+            BenchSeries series[2];
+            bench_file(dlls, series, abs_path_w, format_code, mode, opts, buf);
+
+            for (int d = 0; d < 2; d++) {
+                print_record(first, dlls[d], abs_path, format_code, mode, bytes, series[d]);
+                first = false;
+                if (series[d].props_mismatches > 0) {
+                    fprintf(stderr, "MISMATCH: %s %s property blocks differed in %u iterations\n",
+                            dlls[d].dll_name, g_cache_names[mode], series[d].props_mismatches);
+                    meta_failures++;
+                }
+            }
+            fflush(stdout);
+
+            // Only files both DLLs decode count toward the format comparison
+            if (!series[0].times_ms.empty() && !series[1].times_ms.empty()) {
+                FormatTotals& t = totals[m][format_code];
+                t.median_ms[0] += compute_stats(series[0].times_ms).median_ms;
+                t.median_ms[1] += compute_stats(series[1].times_ms).median_ms;
+                t.files++;
+            }
+        }
+    }
+
+    printf("\n]\n");
+
+    fprintf(stderr, "\nPer-format median time (ms, summed over files both DLLs decode):\n");
+    fprintf(stderr, "  %-5s %-16s %-9s %6s %12s %12s %8s\n",
+            "code", "format", "cache", "files", "original", "rebuilt", "ratio");
+    for (int m = CACHE_WARM; m < CACHE_MODES; m++) {
+        for (std::map<int, FormatTotals>::const_iterator it = totals[m].begin(); it != totals[m].end(); ++it) {
+            const FormatTotals& t = it->second;
+            double ratio = t.median_ms[0] > 0.0 ? t.median_ms[1] / t.median_ms[0] : 0.0;
+            fprintf(stderr, "  %-5d %-16s %-9s %6u %12.3f %12.3f %7.2fx%s\n",
+                    it->first, format_name(it->first), g_cache_names[m], t.files,
+                    t.median_ms[0], t.median_ms[1], ratio,
+                    is_slower(t.median_ms[0], t.median_ms[1]) ? "  SLOWER" : "");
+        }
+    }
+
+    buffer_free(buf);
+    unload_dll(dlls[0]);
+    unload_dll(dlls[1]);
+    int ret = 0;
+    if (meta_failures > 0) {
+        fprintf(stderr, "[FAIL] metadata modes: %u runs read inconsistent properties\n",
+                meta_failures);
+        ret = 1;
+    }
+    return ret;
+}
@@ -13,6 +13,17 @@
  *   cl /EHsc /MD /D_AFXDLL mfc_host.cpp /link /SUBSYSTEM:CONSOLE mfc140.lib
  *
  * Or just use the workflow that compiles it with MSBuild.
+ *
+ * Usage:
+ *   mfc_host [options] <original_dll> <rebuilt_dll> <test_file>
+ *   mfc_host [options] <original_dll> <rebuilt_dll> <test_dir>
+ *   mfc_host [options] <original_dll> <rebuilt_dll> @<manifest>
+ *
+ * The default run opens every file with both DLLs, compares them sample by
+ * sample and writes one JSON record per DLL and file to stdout. --matrix,
+ * --scale, --startup, --alloc-soak, --soak, --fuzz, --roundtrip and --detect
+ * replace that check with another mode. mfc_host --help lists the options
+ * and what each mode records; README.md has examples.
  */
 
 // Force MFC to be included
@@ -21,8 +32,19 @@
 #include <afxwin.h>
 
 #include <windows.h>
+#include <intrin.h>
+#include <immintrin.h>
+#include <malloc.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "aud_host.h"
 
 // Minimal MFC application class
 class CTestApp : public CWinApp {
@@ -35,246 +57,929 @@ public:
 // Global MFC app instance
 CTestApp theApp;
 
-// DLL function signatures
-typedef double (__cdecl *Aud_GetInterfaceVersion_t)(void);
-typedef double (__cdecl *Aud_GetDllVersion_t)(void);
-typedef unsigned int (__cdecl *Aud_InitDll_t)(unsigned int magic);
-// CORRECTED: signature is (path, format_code, extra) not (format, path, hint)
-typedef int (__cdecl *Aud_OpenGetFile_t)(const wchar_t* path, int format, int extra);
-typedef int (__cdecl *Aud_GetNumberOfFiles_t)(unsigned int* out_count);
-typedef int (__cdecl *Aud_GetNumberOfChannels_t)(unsigned int file_idx, unsigned int* out_count);
-typedef int (__cdecl *Aud_CloseGetFile_t)(void);
-typedef int (__cdecl *Aud_GetChannelDataDoubles_t)(unsigned int file_idx, unsigned int channel_idx,
-                                                    double* buffer, unsigned int* count);
-typedef int (__cdecl *Aud_GetFileProperties_t)(unsigned int file_idx, void* props);
-
-#define AUD_MAGIC 0x42754C2E
-
-// Format codes from decompiled wrapper
-int get_format_code(const wchar_t* path) {
-    const wchar_t* ext = wcsrchr(path, L'.');
-    if (!ext) return 0;
-
-    if (_wcsicmp(ext, L".etm") == 0) return 1;   // AudioMeasureEtm
-    if (_wcsicmp(ext, L".efr") == 0) return 2;   // AudioMeasureEfr
-    if (_wcsicmp(ext, L".emd") == 0) return 3;   // AudioMeasureEmd
-    if (_wcsicmp(ext, L".etx") == 0) return 5;   // AudioMeasureEtx
-    if (_wcsicmp(ext, L".wav") == 0) return 9;   // MsWave
-    if (_wcsicmp(ext, L".tim") == 0) return 10;  // MlssaTim
-    if (_wcsicmp(ext, L".frq") == 0) return 11;  // MlssaFrq
-    if (_wcsicmp(ext, L".dat") == 0) return 12;  // MonkeyForestDat
-    if (_wcsicmp(ext, L".spk") == 0) return 13;  // MonkeyForestSpk
-    if (_wcsicmp(ext, L".frd") == 0) return 24;  // ClioFreqText
-    if (_wcsicmp(ext, L".zma") == 0) return 24;  // ClioFreqText (impedance)
-    return 0;  // Auto-detect
+// ============================================================================
+// Sample comparison engine
+// ============================================================================
+
+// Samples handed to the diff kernel per call; keeps both inputs in L2
+#define COMPARE_CHUNK 16384
+
+#define NO_DIVERGENCE ((size_t)-1)
+
+// Running diff statistics for one channel pair
+struct SampleDiff {
+    size_t samples;             // Samples compared so far
+    size_t mismatched;          // Samples whose bit patterns differ
+    size_t first_divergence;    // Index of first differing sample, or NO_DIVERGENCE
+    unsigned long long max_ulp; // Largest distance in units in the last place
+    double max_abs_error;       // Largest |a - b| (NaN differences are not counted)
+};
+
+void diff_reset(SampleDiff& d) {
+    d.samples = 0;
+    d.mismatched = 0;
+    d.first_divergence = NO_DIVERGENCE;
+    d.max_ulp = 0;
+    d.max_abs_error = 0.0;
+}
+
+void diff_merge(SampleDiff& into, const SampleDiff& d) {
+    into.samples += d.samples;
+    into.mismatched += d.mismatched;
+    if (d.max_ulp > into.max_ulp) into.max_ulp = d.max_ulp;
+    if (d.max_abs_error > into.max_abs_error) into.max_abs_error = d.max_abs_error;
+}
+
+// Map a double's bits onto a signed integer line where adjacent doubles are
+// adjacent integers (and +0 / -0 both map to 0). The kernels count any two
+// different bit patterns at least 1 ULP apart, so --max-ulp 0 stays
+// bit-exact and tells -0 from +0.
+static inline long long ordered_bits(double x) {
+    long long i;
+    memcpy(&i, &x, sizeof(i));
+    return i < 0 ? (long long)(0x8000000000000000ULL - (unsigned long long)i) : i;
+}
+
+static void diff_scalar(SampleDiff& d, const double* a, const double* b, size_t n, size_t base) {
+    for (size_t i = 0; i < n; i++) {
+        unsigned long long ia, ib;
+        memcpy(&ia, &a[i], sizeof(ia));
+        memcpy(&ib, &b[i], sizeof(ib));
+        if (ia == ib) continue;
+
+        d.mismatched++;
+        if (d.first_divergence == NO_DIVERGENCE) d.first_divergence = base + i;
+
+        long long ka = ordered_bits(a[i]);
+        long long kb = ordered_bits(b[i]);
+        unsigned long long ulp = ka > kb ? (unsigned long long)ka - (unsigned long long)kb
+                                         : (unsigned long long)kb - (unsigned long long)ka;
+        if (ulp == 0) ulp = 1;      // +0 vs -0
+        if (ulp > d.max_ulp) d.max_ulp = ulp;
+
+        double err = fabs(a[i] - b[i]);
+        if (err > d.max_abs_error) d.max_abs_error = err;
+    }
+}
+
+static inline __m256i ordered_bits_avx2(__m256i v, __m256i sign) {
+    __m256i neg = _mm256_cmpgt_epi64(_mm256_setzero_si256(), v);
+    return _mm256_blendv_epi8(v, _mm256_sub_epi64(sign, v), neg);
+}
+
+static void diff_avx2(SampleDiff& d, const double* a, const double* b, size_t n, size_t base) {
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    __m256i max_ulp = sign;     // Unsigned max, kept biased by the sign bit
+    __m256d max_err = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d va = _mm256_loadu_pd(a + i);
+        __m256d vb = _mm256_loadu_pd(b + i);
+        __m256i ia = _mm256_castpd_si256(va);
+        __m256i ib = _mm256_castpd_si256(vb);
+
+        int equal = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(ia, ib)));
+        if (equal == 0xF) continue;
+
+        int diff_lanes = ~equal & 0xF;
+        for (int lane = 0; lane < 4; lane++) {
+            if (diff_lanes & (1 << lane)) {
+                d.mismatched++;
+                if (d.first_divergence == NO_DIVERGENCE) d.first_divergence = base + i + lane;
+            }
+        }
+
+        __m256i ka = ordered_bits_avx2(ia, sign);
+        __m256i kb = ordered_bits_avx2(ib, sign);
+        __m256i a_gt = _mm256_cmpgt_epi64(ka, kb);
+        __m256i ulp = _mm256_blendv_epi8(_mm256_sub_epi64(kb, ka), _mm256_sub_epi64(ka, kb), a_gt);
+        // +0 vs -0: different bits at distance 0 becomes 1 (all-ones lanes subtract -1)
+        __m256i zero_dist = _mm256_andnot_si256(_mm256_cmpeq_epi64(ia, ib),
+                                                _mm256_cmpeq_epi64(ulp, _mm256_setzero_si256()));
+        ulp = _mm256_sub_epi64(ulp, zero_dist);
+        __m256i ulp_biased = _mm256_xor_si256(ulp, sign);
+        max_ulp = _mm256_blendv_epi8(max_ulp, ulp_biased, _mm256_cmpgt_epi64(ulp_biased, max_ulp));
+
+        // max_pd returns its second operand when the first is NaN
+        __m256d err = _mm256_and_pd(_mm256_sub_pd(va, vb), abs_mask);
+        max_err = _mm256_max_pd(err, max_err);
+    }
+
+    unsigned long long ulp_lanes[4];
+    double err_lanes[4];
+    _mm256_storeu_si256((__m256i*)ulp_lanes, max_ulp);
+    _mm256_storeu_pd(err_lanes, max_err);
+    for (int lane = 0; lane < 4; lane++) {
+        unsigned long long ulp = ulp_lanes[lane] ^ 0x8000000000000000ULL;
+        if (ulp > d.max_ulp) d.max_ulp = ulp;
+        if (err_lanes[lane] > d.max_abs_error) d.max_abs_error = err_lanes[lane];
+    }
+
+    diff_scalar(d, a + i, b + i, n - i, base + i);
+}
+
+bool cpu_has_avx2() {
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    // OSXSAVE + AVX, and the OS must save YMM state
+    if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+}
+
+typedef void (*diff_kernel_t)(SampleDiff& d, const double* a, const double* b, size_t n, size_t base);
+static diff_kernel_t g_diff_kernel = diff_scalar;
+
+// Diff n samples starting at sample index base, chunk by chunk
+void diff_samples(SampleDiff& d, const double* a, const double* b, size_t n, size_t base) {
+    for (size_t off = 0; off < n; off += COMPARE_CHUNK) {
+        size_t len = n - off < COMPARE_CHUNK ? n - off : COMPARE_CHUNK;
+        g_diff_kernel(d, a + off, b + off, len, base + off);
+    }
+    d.samples += n;
 }
 
+// One channel read by test_dll()
+struct ChannelResult {
+    unsigned int file_idx;
+    unsigned int channel_idx;
+    int ret;
+    int sample_count;
+    double first_sample;
+    double last_sample;
+    double size_query_ms;   // Aud_GetChannelDataDoubles(NULL) call
+    double read_ms;         // Aud_GetChannelDataDoubles(buffer) call
+};
+
 struct TestResult {
     const char* dll_name;
-    const char* test_file;
+    std::string test_file;
     double interface_version;
     double dll_version;
     unsigned int session_magic;
+    int format_code;        // Passed to Aud_OpenGetFile (get_format_code)
+    int sniffed_format;     // Host magic-byte table (sniffed_format_code)
     int open_ret;
     int num_files;
-    int num_channels;
-    int sample_count;
+    int num_channels;       // Channels in file 0
+    int total_channels;     // Channels across all files
+    int sample_count;       // File 0 / channel 0, as before
+    unsigned int oversized_channels;    // Channels too large for the host buffer (SAMPLE_BUFFER_MAX)
     double first_sample;
     double last_sample;
+    std::vector<ChannelResult> channels;
+
+    // Per-export wall time in ms; channel calls are summed over all channels
+    double load_ms;         // LoadLibraryA
+    double init_ms;
+    double open_ms;
+    double num_files_ms;
+    double num_channels_ms;
+    double size_query_ms;
+    double read_ms;
+    double close_ms;
+
+    // Process memory just before Aud_OpenGetFile and just after
+    // Aud_CloseGetFile, and the DLL's own heap calls in between
+    MemorySnapshot mem_before;
+    MemorySnapshot mem_after;
+    HeapCounters heap;
+    bool heap_tracked;
+};
+
+// Latency of each export summed over a batch, for the end-of-run table
+enum ExportId {
+    EXP_LOAD, EXP_INIT, EXP_OPEN, EXP_NUM_FILES, EXP_NUM_CHANNELS, EXP_SIZE_QUERY, EXP_READ, EXP_CLOSE,
+    EXP_COUNT
+};
+
+static const char* const g_export_names[EXP_COUNT] = {
+    "LoadLibraryA", "Aud_InitDll", "Aud_OpenGetFile", "Aud_GetNumberOfFiles", "Aud_GetNumberOfChannels",
+    "Aud_GetChannelDataDoubles(NULL)", "Aud_GetChannelDataDoubles(buf)", "Aud_CloseGetFile"
+};
+
+struct LatencyTotals {
+    double ms[EXP_COUNT];
+    unsigned int calls;     // Files that contributed
+};
+
+// Per-file times only count files both DLLs opened (both_opened), so the
+// two columns cover the same work
+void latency_add(LatencyTotals& t, const TestResult& r, bool both_opened) {
+    if (r.open_ret == -999) return;
+    t.ms[EXP_LOAD] = r.load_ms;     // Once per DLL load, not per file
+    t.ms[EXP_INIT] = r.init_ms;
+    if (!both_opened) return;
+    t.ms[EXP_OPEN] += r.open_ms;
+    t.ms[EXP_NUM_FILES] += r.num_files_ms;
+    t.ms[EXP_NUM_CHANNELS] += r.num_channels_ms;
+    t.ms[EXP_SIZE_QUERY] += r.size_query_ms;
+    t.ms[EXP_READ] += r.read_ms;
+    t.ms[EXP_CLOSE] += r.close_ms;
+    t.calls++;
+}
+
+void print_latency_table(const LatencyTotals& orig, const LatencyTotals& rebuilt) {
+    fprintf(stderr, "\nExport latency (ms, summed over %u files both DLLs opened):\n", rebuilt.calls);
+    fprintf(stderr, "  %-32s %12s %12s %8s\n", "export", "original", "rebuilt", "ratio");
+    for (int i = 0; i < EXP_COUNT; i++) {
+        double ratio = orig.ms[i] > 0.0 ? rebuilt.ms[i] / orig.ms[i] : 0.0;
+        fprintf(stderr, "  %-32s %12.3f %12.3f %7.2fx%s\n", g_export_names[i],
+                orig.ms[i], rebuilt.ms[i], ratio,
+                orig.calls > 0 && is_slower(orig.ms[i], rebuilt.ms[i]) ? "  SLOWER" : "");
+    }
+}
+
+// Heap activity summed over a batch. Outstanding blocks that keep growing
+// with the file count are what a long-running service sees as a leak.
+struct MemoryTotals {
+    HeapCounters heap;
+    long long private_bytes_delta;
+    unsigned cycles;
+    bool heap_tracked;
+};
+
+void memory_add(MemoryTotals& t, const TestResult& r) {
+    t.heap.allocs += r.heap.allocs;
+    t.heap.reallocs += r.heap.reallocs;
+    t.heap.frees += r.heap.frees;
+    t.heap.alloc_bytes += r.heap.alloc_bytes;
+    t.private_bytes_delta += (long long)(r.mem_after.private_bytes - r.mem_before.private_bytes);
+    t.heap_tracked = r.heap_tracked;
+    t.cycles++;
+}
+
+void print_memory_table(const MemoryTotals& orig, const MemoryTotals& rebuilt) {
+    if (orig.cycles == 0) return;
+    fprintf(stderr, "\n%-12s %14s %14s %14s %14s %16s\n", "dll", "allocs/file", "bytes/file",
+            "outstanding", "frees", "private_delta");
+    const MemoryTotals* rows[2] = { &orig, &rebuilt };
+    const char* names[2] = { "original", "rebuilt" };
+    for (int i = 0; i < 2; i++) {
+        const MemoryTotals& t = *rows[i];
+        if (!t.heap_tracked) {
+            fprintf(stderr, "%-12s %14s %14s %14s %14s %16lld\n", names[i], "-", "-", "-", "-",
+                    t.private_bytes_delta);
+            continue;
+        }
+        fprintf(stderr, "%-12s %14.1f %14.1f %14lld %14lld %16lld%s\n", names[i],
+                (double)t.heap.allocs / t.cycles, (double)t.heap.alloc_bytes / t.cycles,
+                t.heap.allocs - t.heap.frees, t.heap.frees, t.private_bytes_delta,
+                t.heap.allocs > t.heap.frees ? "  allocs > frees" : "");
+    }
+    fprintf(stderr, "(allocs > frees is a heuristic: caches and blocks freed at unload count too)\n");
+}
+
+struct ChannelCompare {
+    unsigned int file_idx;
+    unsigned int channel_idx;
+    int orig_ret;
+    int rebuilt_ret;
+    unsigned int orig_count;
+    unsigned int rebuilt_count;
+    SampleDiff diff;
+};
+
+// Sample-level comparison of one file between the two DLLs
+struct CompareResult {
+    bool ran;
+    bool structure_match;       // Same file/channel/sample counts and return codes
+    std::vector<ChannelCompare> channels;
+    SampleDiff total;
+    const ChannelCompare* first_divergence;
+};
+
+void print_json_compare(const CompareResult& c) {
+    printf("    \"compare\": {\n");
+    printf("      \"structure_match\": %s,\n", c.structure_match ? "true" : "false");
+    printf("      \"channels\": %u,\n", (unsigned)c.channels.size());
+    printf("      \"samples\": %llu,\n", (unsigned long long)c.total.samples);
+    printf("      \"mismatched_samples\": %llu,\n", (unsigned long long)c.total.mismatched);
+    printf("      \"max_ulp\": %llu,\n", c.total.max_ulp);
+    printf("      \"max_abs_error\": %.17g,\n", c.total.max_abs_error);
+    if (c.first_divergence) {
+        printf("      \"first_divergence\": {\"file_idx\": %u, \"channel_idx\": %u, \"sample\": %llu},\n",
+               c.first_divergence->file_idx, c.first_divergence->channel_idx,
+               (unsigned long long)c.first_divergence->diff.first_divergence);
+    } else {
+        printf("      \"first_divergence\": null,\n");
+    }
+    printf("      \"per_channel\": [");
+    for (size_t i = 0; i < c.channels.size(); i++) {
+        const ChannelCompare& ch = c.channels[i];
+        printf("%s\n        {\"file_idx\": %u, \"channel_idx\": %u, \"orig_ret\": %d, \"rebuilt_ret\": %d, "
+               "\"orig_count\": %u, \"rebuilt_count\": %u, \"max_ulp\": %llu, \"max_abs_error\": %.17g, "
+               "\"first_divergence\": %lld}",
+               i ? "," : "", ch.file_idx, ch.channel_idx, ch.orig_ret, ch.rebuilt_ret,
+               ch.orig_count, ch.rebuilt_count, ch.diff.max_ulp, ch.diff.max_abs_error,
+               ch.diff.first_divergence == NO_DIVERGENCE ? -1LL : (long long)ch.diff.first_divergence);
+    }
+    printf("%s]\n", c.channels.empty() ? "" : "\n      ");
+    printf("    }");
+}
+
+// ============================================================================
+// Channel digests
+//
+// A digest is a channel's ret, sample count and FNV-1a hash of the raw sample
+// bits, enough to compare reads made at different times without keeping the
+// samples around.
+// ============================================================================
+
+struct ChannelDigest {
+    int ret;
+    unsigned int count;
+    unsigned long long hash;
+};
+
+// Per test file: open_ret and one digest per channel of every file_idx
+struct FileDigest {
+    int open_ret;
+    std::vector<ChannelDigest> channels;
+};
+
+#define DIGEST_BASIS 14695981039346656037ULL
+
+// FNV-1a over n bytes, continuing from h
+static unsigned long long digest_bytes(const void* data, size_t n, unsigned long long h = DIGEST_BASIS) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ p[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+static unsigned long long digest_samples(const double* data, unsigned int n) {
+    return digest_bytes(data, (size_t)n * sizeof(double));
+}
+
+static ChannelDigest read_digest(int ret, unsigned int count, const double* data) {
+    ChannelDigest d = { ret, count, 0 };
+    if (ret == 0 && count > 0) d.hash = digest_samples(data, count);
+    return d;
+}
+
+// Size query + read of one channel of the open file
+static ChannelDigest channel_digest(const AudDll& dll, unsigned int f, unsigned int c,
+                                    SampleBuffer& buf) {
+    unsigned int count = 0;
+    int ret = dll.Aud_GetChannelDataDoubles(f, c, NULL, &count);
+    if (ret == 0 && count > 0 && buffer_reserve(buf, count)) {
+        ret = dll.Aud_GetChannelDataDoubles(f, c, buf.data, &count);
+    }
+    return read_digest(ret, count, buf.data);
+}
+
+FileDigest serial_digest(const AudDll& dll, const wchar_t* path_w, SampleBuffer& buf) {
+    FileDigest fd;
+    fd.open_ret = dll.Aud_OpenGetFile(path_w, get_format_code(path_w), 0);
+    if (fd.open_ret != 0) return fd;
+    unsigned int files_count = 1;
+    if (dll.Aud_GetNumberOfFiles) dll.Aud_GetNumberOfFiles(&files_count);
+    for (unsigned int f = 0; f < files_count; f++) {
+        unsigned int channels_count = 0;
+        dll.Aud_GetNumberOfChannels(f, &channels_count);
+        for (unsigned int c = 0; c < channels_count; c++) {
+            fd.channels.push_back(channel_digest(dll, f, c, buf));
+        }
+    }
+    dll.Aud_CloseGetFile();
+    return fd;
+}
+
+static bool digest_equal(const ChannelDigest& x, const ChannelDigest& y) {
+    return x.ret == y.ret && x.count == y.count && x.hash == y.hash;
+}
+
+static bool digest_equal(const FileDigest& a, const FileDigest& b) {
+    if (a.open_ret != b.open_ret || a.channels.size() != b.channels.size()) return false;
+    for (size_t i = 0; i < a.channels.size(); i++) {
+        if (!digest_equal(a.channels[i], b.channels[i])) return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Channel access orders (--access-orders)
+//
+// A DLL that decodes or caches per channel can make a read depend on which
+// channels were requested before it. Every channel is digested in
+// sequential order first. The file is then reopened and read in reverse, in
+// a seeded shuffle, every other channel only (from the last one down), and
+// one channel per open. Every read must match its sequential digest.
+// ============================================================================
+
+enum AccessOrder { ORDER_REVERSE, ORDER_SHUFFLED, ORDER_SPARSE, ORDER_SINGLE, ACCESS_ORDERS };
+
+static const char* const g_access_order_names[] = { "reverse", "shuffled", "sparse", "single" };
+
+struct ChannelRef {
+    unsigned int file_idx;
+    unsigned int channel_idx;
+};
+
+struct OrderResult {
+    unsigned int reads;
+    unsigned int mismatches;
+    int first_mismatch;     // Index into AccessOrderResult::channels, -1 = none
+};
+
+struct AccessOrderResult {
+    bool ran;
+    std::vector<ChannelRef> channels;   // Sequential order
+    OrderResult orders[ACCESS_ORDERS];
 };
 
-void print_json(const TestResult& r) {
+// Sequence of channel indices an order requests
+static std::vector<size_t> access_sequence(AccessOrder order, size_t n) {
+    std::vector<size_t> seq;
+    if (order == ORDER_SPARSE) {
+        for (size_t i = n; i >= 2; i -= 2) seq.push_back(i - 1);
+        if (n % 2 == 1) seq.push_back(0);
+        return seq;
+    }
+    for (size_t i = 0; i < n; i++) seq.push_back(order == ORDER_REVERSE ? n - 1 - i : i);
+    if (order == ORDER_SHUFFLED) {
+        // Fixed seed so failures reproduce
+        unsigned int state = 0x9E3779B9u ^ (unsigned int)n;
+        for (size_t i = n; i > 1; i--) {
+            state = state * 1664525u + 1013904223u;
+            std::swap(seq[i - 1], seq[state % i]);
+        }
+    }
+    return seq;
+}
+
+AccessOrderResult check_access_orders(const AudDll& dll, const wchar_t* path_w, SampleBuffer& buf) {
+    AccessOrderResult ar;
+    ar.ran = false;
+    memset(ar.orders, 0, sizeof(ar.orders));
+    if (!dll.module || !dll.Aud_GetNumberOfChannels || !dll.Aud_GetChannelDataDoubles) return ar;
+
+    FileDigest base = serial_digest(dll, path_w, buf);
+    if (base.open_ret != 0) return ar;
+    unsigned int files_count = 1;
+    int format_code = get_format_code(path_w);
+    if (dll.Aud_OpenGetFile(path_w, format_code, 0) != 0) return ar;
+    if (dll.Aud_GetNumberOfFiles) dll.Aud_GetNumberOfFiles(&files_count);
+    for (unsigned int f = 0; f < files_count; f++) {
+        unsigned int channels_count = 0;
+        dll.Aud_GetNumberOfChannels(f, &channels_count);
+        for (unsigned int c = 0; c < channels_count; c++) {
+            ChannelRef ref = { f, c };
+            ar.channels.push_back(ref);
+        }
+    }
+    dll.Aud_CloseGetFile();
+    if (ar.channels.size() != base.channels.size()) return ar;
+    ar.ran = true;
+
+    for (int o = 0; o < ACCESS_ORDERS; o++) {
+        OrderResult& r = ar.orders[o];
+        r.first_mismatch = -1;
+        std::vector<size_t> seq = access_sequence((AccessOrder)o, ar.channels.size());
+        bool single = o == ORDER_SINGLE;
+        if (!single && dll.Aud_OpenGetFile(path_w, format_code, 0) != 0) {
+            r.mismatches = (unsigned int)seq.size();
+            r.first_mismatch = seq.empty() ? -1 : (int)seq[0];
+            continue;
+        }
+        for (size_t i = 0; i < seq.size(); i++) {
+            const ChannelRef& ref = ar.channels[seq[i]];
+            ChannelDigest d = { -1000, 0, 0 };
+            if (!single || dll.Aud_OpenGetFile(path_w, format_code, 0) == 0) {
+                d = channel_digest(dll, ref.file_idx, ref.channel_idx, buf);
+                if (single) dll.Aud_CloseGetFile();
+            }
+            r.reads++;
+            if (!digest_equal(d, base.channels[seq[i]])) {
+                if (r.first_mismatch < 0) r.first_mismatch = (int)seq[i];
+                r.mismatches++;
+            }
+        }
+        if (!single) dll.Aud_CloseGetFile();
+    }
+    return ar;
+}
+
+void print_json_access_orders(const AccessOrderResult& ar) {
+    printf("    \"access_orders\": [");
+    for (int o = 0; o < ACCESS_ORDERS; o++) {
+        const OrderResult& r = ar.orders[o];
+        printf("%s\n      {\"order\": \"%s\", \"reads\": %u, \"mismatches\": %u, \"first_mismatch\": ",
+               o ? "," : "", g_access_order_names[o], r.reads, r.mismatches);
+        if (r.first_mismatch >= 0) {
+            const ChannelRef& ref = ar.channels[r.first_mismatch];
+            printf("{\"file_idx\": %u, \"channel_idx\": %u}}", ref.file_idx, ref.channel_idx);
+        } else {
+            printf("null}");
+        }
+    }
+    printf("\n    ]");
+}
+
+// Memory around one open/close cycle. The buffers that hold channel data
+// belong to the host and are reused, so once they have grown, working set
+// and private bytes change only through the DLL.
+void print_json_memory(const TestResult& r) {
+    printf("    \"memory\": {\n");
+    printf("      \"working_set_before\": %llu,\n", r.mem_before.working_set);
+    printf("      \"working_set_after\": %llu,\n", r.mem_after.working_set);
+    printf("      \"peak_working_set\": %llu,\n", r.mem_after.peak_working_set);
+    printf("      \"private_bytes_before\": %llu,\n", r.mem_before.private_bytes);
+    printf("      \"private_bytes_after\": %llu,\n", r.mem_after.private_bytes);
+    printf("      \"private_bytes_delta\": %lld,\n",
+           (long long)(r.mem_after.private_bytes - r.mem_before.private_bytes));
+    if (r.heap_tracked) {
+        printf("      \"heap_allocs\": %lld,\n", r.heap.allocs);
+        printf("      \"heap_reallocs\": %lld,\n", r.heap.reallocs);
+        printf("      \"heap_frees\": %lld,\n", r.heap.frees);
+        printf("      \"heap_alloc_bytes\": %lld,\n", r.heap.alloc_bytes);
+        printf("      \"heap_outstanding\": %lld\n", r.heap.allocs - r.heap.frees);
+    } else {
+        printf("      \"heap_allocs\": null\n");
+    }
+    printf("    }");
+}
+
+void print_json(const TestResult& r, const CompareResult* cmp = NULL,
+                const AccessOrderResult* orders = NULL) {
     printf("  {\n");
     printf("    \"dll\": \"%s\",\n", r.dll_name);
-    printf("    \"file\": \"%s\",\n", r.test_file);
+    printf("    \"file\": ");
+    print_json_string(r.test_file.c_str());
+    printf(",\n");
     printf("    \"interface_version\": %.15g,\n", r.interface_version);
     printf("    \"dll_version\": %.15g,\n", r.dll_version);
     printf("    \"session_magic\": \"0x%08x\",\n", r.session_magic);
+    printf("    \"load_ms\": %.4f,\n", r.load_ms);
+    printf("    \"init_ms\": %.4f,\n", r.init_ms);
+    printf("    \"format_code\": %d,\n", r.format_code);
+    printf("    \"sniffed_format\": %d,\n", r.sniffed_format);
     printf("    \"open_ret\": %d,\n", r.open_ret);
+    printf("    \"open_ms\": %.4f,\n", r.open_ms);
     printf("    \"num_files\": %d,\n", r.num_files);
+    printf("    \"num_files_ms\": %.4f,\n", r.num_files_ms);
     printf("    \"num_channels\": %d,\n", r.num_channels);
+    printf("    \"num_channels_ms\": %.4f,\n", r.num_channels_ms);
+    printf("    \"size_query_ms\": %.4f,\n", r.size_query_ms);
+    printf("    \"read_ms\": %.4f,\n", r.read_ms);
+    printf("    \"close_ms\": %.4f,\n", r.close_ms);
+    printf("    \"total_channels\": %d,\n", r.total_channels);
     printf("    \"sample_count\": %d,\n", r.sample_count);
+    if (r.oversized_channels) printf("    \"oversized_channels\": %u,\n", r.oversized_channels);
     printf("    \"first_sample\": %.15g,\n", r.first_sample);
-    printf("    \"last_sample\": %.15g\n", r.last_sample);
-    printf("  }");
+    printf("    \"last_sample\": %.15g,\n", r.last_sample);
+    printf("    \"channels\": [");
+    for (size_t i = 0; i < r.channels.size(); i++) {
+        const ChannelResult& ch = r.channels[i];
+        printf("%s\n      {\"file_idx\": %u, \"channel_idx\": %u, \"ret\": %d, \"sample_count\": %d, "
+               "\"first_sample\": %.15g, \"last_sample\": %.15g, \"size_query_ms\": %.4f, \"read_ms\": %.4f}",
+               i ? "," : "", ch.file_idx, ch.channel_idx, ch.ret, ch.sample_count,
+               ch.first_sample, ch.last_sample, ch.size_query_ms, ch.read_ms);
+    }
+    printf("%s],\n", r.channels.empty() ? "" : "\n    ");
+    print_json_memory(r);
+    if (cmp && cmp->ran) {
+        printf(",\n");
+        print_json_compare(*cmp);
+    }
+    if (orders && orders->ran) {
+        printf(",\n");
+        print_json_access_orders(*orders);
+    }
+    printf("\n  }");
+}
+
+// The same record in the binary stream (--format binary): core fields,
+// timings, memory and channels. The --access-orders block stays JSON
+// only; their outcome is in the compare record's passed flag.
+void record_result(RecordWriter& w, const TestResult& r, unsigned char dll) {
+    AudResultRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.dll = dll;
+    rec.heap_tracked = r.heap_tracked ? 1 : 0;
+    rec.format_code = r.format_code;
+    rec.sniffed_format = r.sniffed_format;
+    rec.open_ret = r.open_ret;
+    rec.num_files = r.num_files;
+    rec.num_channels = r.num_channels;
+    rec.total_channels = r.total_channels;
+    rec.sample_count = r.sample_count;
+    rec.session_magic = r.session_magic;
+    rec.path_len = (unsigned int)r.test_file.size();
+    rec.channel_count = (unsigned int)r.channels.size();
+    rec.interface_version = r.interface_version;
+    rec.dll_version = r.dll_version;
+    rec.first_sample = r.first_sample;
+    rec.last_sample = r.last_sample;
+    rec.load_ms = r.load_ms;
+    rec.init_ms = r.init_ms;
+    rec.open_ms = r.open_ms;
+    rec.num_files_ms = r.num_files_ms;
+    rec.num_channels_ms = r.num_channels_ms;
+    rec.size_query_ms = r.size_query_ms;
+    rec.read_ms = r.read_ms;
+    rec.close_ms = r.close_ms;
+    rec.working_set_before = r.mem_before.working_set;
+    rec.working_set_after = r.mem_after.working_set;
+    rec.peak_working_set = r.mem_after.peak_working_set;
+    rec.private_bytes_before = r.mem_before.private_bytes;
+    rec.private_bytes_after = r.mem_after.private_bytes;
+    if (r.heap_tracked) {
+        rec.heap_allocs = r.heap.allocs;
+        rec.heap_reallocs = r.heap.reallocs;
+        rec.heap_frees = r.heap.frees;
+        rec.heap_alloc_bytes = r.heap.alloc_bytes;
+    }
+
+    record_begin(w, AUD_REC_RESULT);
+    record_put(w, &rec, sizeof(rec));
+    record_put(w, r.test_file.data(), r.test_file.size());
+    for (size_t i = 0; i < r.channels.size(); i++) {
+        const ChannelResult& ch = r.channels[i];
+        AudChannelRecord c = { ch.file_idx, ch.channel_idx, ch.ret, ch.sample_count,
+                               ch.first_sample, ch.last_sample,
+                               (float)ch.size_query_ms, (float)ch.read_ms };
+        record_put(w, &c, sizeof(c));
+    }
+    record_end(w);
+}
+
+void record_compare(RecordWriter& w, const CompareResult& cmp, bool passed) {
+    AudCompareRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.ran = cmp.ran ? 1 : 0;
+    rec.passed = passed ? 1 : 0;
+    rec.first_divergence = -1;
+    if (cmp.ran) {
+        rec.structure_match = cmp.structure_match ? 1 : 0;
+        rec.channel_count = (unsigned int)cmp.channels.size();
+        rec.samples = cmp.total.samples;
+        rec.mismatched_samples = cmp.total.mismatched;
+        rec.max_ulp = cmp.total.max_ulp;
+        rec.max_abs_error = cmp.total.max_abs_error;
+        if (cmp.first_divergence) {
+            rec.has_divergence = 1;
+            rec.first_divergence_file_idx = cmp.first_divergence->file_idx;
+            rec.first_divergence_channel_idx = cmp.first_divergence->channel_idx;
+            rec.first_divergence = (long long)cmp.first_divergence->diff.first_divergence;
+        }
+    }
+
+    record_begin(w, AUD_REC_COMPARE);
+    record_put(w, &rec, sizeof(rec));
+    for (unsigned int i = 0; i < rec.channel_count; i++) {
+        const ChannelCompare& ch = cmp.channels[i];
+        AudChannelCompareRecord c = { ch.file_idx, ch.channel_idx, ch.orig_ret, ch.rebuilt_ret,
+                                      ch.orig_count, ch.rebuilt_count, ch.diff.max_ulp,
+                                      ch.diff.max_abs_error,
+                                      ch.diff.first_divergence == NO_DIVERGENCE
+                                          ? -1LL : (long long)ch.diff.first_divergence };
+        record_put(w, &c, sizeof(c));
+    }
+    record_end(w);
 }
 
-TestResult test_dll(const char* dll_path, const char* dll_name,
-                    const wchar_t* test_file_w, const char* test_file) {
+// Open the file and read every channel of every file into the shared buffer
+TestResult test_dll(const AudDll& dll, const wchar_t* test_file_w, const char* test_file,
+                    SampleBuffer& buf) {
     TestResult result = {};
-    result.dll_name = dll_name;
+    result.dll_name = dll.dll_name;
     result.test_file = test_file;
     result.open_ret = -999;  // Sentinel for "not tested"
+    result.format_code = get_format_code(test_file_w);
+    result.sniffed_format = sniffed_format_code(test_file_w);
     result.num_files = -1;
     result.num_channels = -1;
+    result.total_channels = -1;
     result.sample_count = -1;
     result.first_sample = 0;
     result.last_sample = 0;
 
-    // Change to DLL directory for any dependencies
-    char dll_dir[MAX_PATH];
-    strcpy_s(dll_dir, dll_path);
-    char* last_slash = strrchr(dll_dir, '\\');
-    if (!last_slash) last_slash = strrchr(dll_dir, '/');
-    if (last_slash) *last_slash = '\0';
-
-    char old_dir[MAX_PATH];
-    GetCurrentDirectoryA(MAX_PATH, old_dir);
-    SetCurrentDirectoryA(dll_dir);
-
-    HMODULE hDll = LoadLibraryA(dll_path);
-    SetCurrentDirectoryA(old_dir);
-
-    if (!hDll) {
-        fprintf(stderr, "ERROR: Failed to load DLL: %s (error %lu)\n", dll_path, GetLastError());
-        return result;
-    }
-
-    // Get function pointers
-    Aud_GetInterfaceVersion_t Aud_GetInterfaceVersion =
-        (Aud_GetInterfaceVersion_t)GetProcAddress(hDll, "Aud_GetInterfaceVersion");
-    Aud_GetDllVersion_t Aud_GetDllVersion =
-        (Aud_GetDllVersion_t)GetProcAddress(hDll, "Aud_GetDllVersion");
-    Aud_InitDll_t Aud_InitDll =
-        (Aud_InitDll_t)GetProcAddress(hDll, "Aud_InitDll");
-    Aud_OpenGetFile_t Aud_OpenGetFile =
-        (Aud_OpenGetFile_t)GetProcAddress(hDll, "Aud_OpenGetFile");
-    Aud_GetNumberOfFiles_t Aud_GetNumberOfFiles =
-        (Aud_GetNumberOfFiles_t)GetProcAddress(hDll, "Aud_GetNumberOfFiles");
-    Aud_GetNumberOfChannels_t Aud_GetNumberOfChannels =
-        (Aud_GetNumberOfChannels_t)GetProcAddress(hDll, "Aud_GetNumberOfChannels");
-    Aud_CloseGetFile_t Aud_CloseGetFile =
-        (Aud_CloseGetFile_t)GetProcAddress(hDll, "Aud_CloseGetFile");
-    Aud_GetChannelDataDoubles_t Aud_GetChannelDataDoubles =
-        (Aud_GetChannelDataDoubles_t)GetProcAddress(hDll, "Aud_GetChannelDataDoubles");
-
-    if (!Aud_InitDll || !Aud_OpenGetFile) {
-        fprintf(stderr, "ERROR: Failed to get function pointers from %s\n", dll_path);
-        FreeLibrary(hDll);
+    if (!dll.module) {
         return result;
     }
+    result.interface_version = dll.interface_version;
+    result.dll_version = dll.dll_version;
+    result.session_magic = dll.session_magic;
+    result.load_ms = dll.load_ms;
+    result.init_ms = dll.init_ms;
 
-    // Get versions
-    if (Aud_GetInterfaceVersion) {
-        result.interface_version = Aud_GetInterfaceVersion();
-    }
-    if (Aud_GetDllVersion) {
-        result.dll_version = Aud_GetDllVersion();
-    }
-
-    // Initialize
-    result.session_magic = Aud_InitDll(AUD_MAGIC);
-    if (result.session_magic == 0) {
-        fprintf(stderr, "WARNING: Aud_InitDll returned 0 for %s\n", dll_name);
-    }
+    result.heap_tracked = dll.heap_slot >= 0;
+    HeapCounters heap_before = heap_counters(dll.heap_slot);
+    result.mem_before = memory_snapshot();
 
-    // Open file with correct format code
-    int format_code = get_format_code(test_file_w);
-    result.open_ret = Aud_OpenGetFile(test_file_w, format_code, 0);
+    // Open file with the extension's format code
+    LONGLONG t0 = timer_now();
+    result.open_ret = dll.Aud_OpenGetFile(test_file_w, result.format_code, 0);
+    result.open_ms = timer_ms(t0, timer_now());
 
     if (result.open_ret == 0) {
-        // Get file count
-        unsigned int files_count = 0;
-        if (Aud_GetNumberOfFiles) {
-            Aud_GetNumberOfFiles(&files_count);
+        result.sample_count = 0;    // Stays 0 when file 0 has no channel to read
+        // Get file count (containers such as SPK hold several)
+        unsigned int files_count = 1;
+        if (dll.Aud_GetNumberOfFiles) {
+            t0 = timer_now();
+            dll.Aud_GetNumberOfFiles(&files_count);
+            result.num_files_ms = timer_ms(t0, timer_now());
             result.num_files = (int)files_count;
         }
 
-        // Get channel count
-        unsigned int channels_count = 0;
-        if (Aud_GetNumberOfChannels) {
-            Aud_GetNumberOfChannels(0, &channels_count);
-            result.num_channels = (int)channels_count;
-        }
-
-        // Read sample data
-        if (Aud_GetChannelDataDoubles && channels_count > 0) {
-            // First call with NULL to get count
-            unsigned int sample_count = 0;
-            int ret = Aud_GetChannelDataDoubles(0, 0, NULL, &sample_count);
-            if (ret == 0 && sample_count > 0) {
-                result.sample_count = (int)sample_count;
-
-                // Allocate and read
-                double* samples = (double*)malloc(sample_count * sizeof(double));
-                if (samples) {
+        result.total_channels = 0;
+        for (unsigned int f = 0; f < files_count; f++) {
+            unsigned int channels_count = 0;
+            if (dll.Aud_GetNumberOfChannels) {
+                t0 = timer_now();
+                dll.Aud_GetNumberOfChannels(f, &channels_count);
+                result.num_channels_ms += timer_ms(t0, timer_now());
+            }
+            if (f == 0) result.num_channels = dll.Aud_GetNumberOfChannels ? (int)channels_count : -1;
+            result.total_channels += (int)channels_count;
+
+            if (!dll.Aud_GetChannelDataDoubles) continue;
+
+            for (unsigned int c = 0; c < channels_count; c++) {
+                ChannelResult ch = {};
+                ch.file_idx = f;
+                ch.channel_idx = c;
+                ch.sample_count = -1;
+
+                // First call with NULL to get count
+                unsigned int sample_count = 0;
+                t0 = timer_now();
+                ch.ret = dll.Aud_GetChannelDataDoubles(f, c, NULL, &sample_count);
+                LONGLONG t1 = timer_now();
+                ch.size_query_ms = timer_ms(t0, t1);
+                result.size_query_ms += ch.size_query_ms;
+
+                if (ch.ret == 0 && sample_count == 0) {
+                    ch.sample_count = 0;
+                } else if (ch.ret == 0 && !buffer_reserve(buf, sample_count)) {
+                    fprintf(stderr, "ERROR: %s DLL: file %u channel %u has %u samples, more than "
+                            "the host can buffer (%u)\n", dll.dll_name, f, c, sample_count,
+                            (unsigned)SAMPLE_BUFFER_MAX);
+                    result.oversized_channels++;
+                } else if (ch.ret == 0) {
+                    ch.sample_count = (int)sample_count;
                     unsigned int count = sample_count;
-                    ret = Aud_GetChannelDataDoubles(0, 0, samples, &count);
-                    if (ret == 0) {
-                        result.first_sample = samples[0];
-                        result.last_sample = samples[count - 1];
+                    t0 = timer_now();
+                    ch.ret = dll.Aud_GetChannelDataDoubles(f, c, buf.data, &count);
+                    t1 = timer_now();
+                    ch.read_ms = timer_ms(t0, t1);
+                    result.read_ms += ch.read_ms;
+                    if (ch.ret == 0 && count > 0) {
+                        ch.first_sample = buf.data[0];
+                        ch.last_sample = buf.data[count - 1];
                     }
-                    free(samples);
                 }
+
+                if (f == 0 && c == 0) {
+                    result.sample_count = ch.sample_count;
+                    result.first_sample = ch.first_sample;
+                    result.last_sample = ch.last_sample;
+                }
+                result.channels.push_back(ch);
             }
         }
 
         // Close file
-        if (Aud_CloseGetFile) {
-            Aud_CloseGetFile();
+        if (dll.Aud_CloseGetFile) {
+            t0 = timer_now();
+            dll.Aud_CloseGetFile();
+            result.close_ms = timer_ms(t0, timer_now());
         }
     }
 
-    FreeLibrary(hDll);
+    result.mem_after = memory_snapshot();
+    result.heap = heap_counters_delta(heap_counters(dll.heap_slot), heap_before);
     return result;
 }
 
-int main(int argc, char* argv[]) {
-    // Initialize MFC
-    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
-        fprintf(stderr, "ERROR: MFC initialization failed\n");
-        return 1;
-    }
+// Open the file in both DLLs at once (each keeps its own open-file state)
+// and diff every channel of every file
+CompareResult compare_dlls(const AudDll& orig, const AudDll& rebuilt, const wchar_t* test_file_w,
+                           SampleBuffer& orig_buf, SampleBuffer& rebuilt_buf) {
+    CompareResult cmp;
+    cmp.ran = false;
+    cmp.structure_match = true;
+    cmp.first_divergence = NULL;
+    diff_reset(cmp.total);
 
-    if (argc < 4) {
-        fprintf(stderr, "Usage: %s <original_dll> <rebuilt_dll> <test_file>\n", argv[0]);
-        fprintf(stderr, "\nThis MFC host application tests target.dll file I/O.\n");
-        fprintf(stderr, "The original DLL requires MFC context to work properly.\n");
-        return 1;
+    if (!orig.module || !rebuilt.module ||
+        !orig.Aud_GetChannelDataDoubles || !rebuilt.Aud_GetChannelDataDoubles) {
+        return cmp;
     }
 
-    const char* original_dll = argv[1];
-    const char* rebuilt_dll = argv[2];
-    const char* test_file = argv[3];
-
-    // Convert test file path to wide string
-    int len = MultiByteToWideChar(CP_UTF8, 0, test_file, -1, NULL, 0);
-    wchar_t* test_file_w = (wchar_t*)malloc(len * sizeof(wchar_t));
-    MultiByteToWideChar(CP_UTF8, 0, test_file, -1, test_file_w, len);
+    int format_code = get_format_code(test_file_w);
+    int orig_open = orig.Aud_OpenGetFile(test_file_w, format_code, 0);
+    int rebuilt_open = rebuilt.Aud_OpenGetFile(test_file_w, format_code, 0);
+    if (orig_open != 0 || rebuilt_open != 0) {
+        if (orig_open == 0 && orig.Aud_CloseGetFile) orig.Aud_CloseGetFile();
+        if (rebuilt_open == 0 && rebuilt.Aud_CloseGetFile) rebuilt.Aud_CloseGetFile();
+        return cmp;
+    }
+    cmp.ran = true;
 
-    // Get absolute path for test file
-    char abs_path[MAX_PATH];
-    GetFullPathNameA(test_file, MAX_PATH, abs_path, NULL);
-    wchar_t abs_path_w[MAX_PATH];
-    MultiByteToWideChar(CP_UTF8, 0, abs_path, -1, abs_path_w, MAX_PATH);
+    unsigned int orig_files = 1, rebuilt_files = 1;
+    if (orig.Aud_GetNumberOfFiles) orig.Aud_GetNumberOfFiles(&orig_files);
+    if (rebuilt.Aud_GetNumberOfFiles) rebuilt.Aud_GetNumberOfFiles(&rebuilt_files);
+    if (orig_files != rebuilt_files) cmp.structure_match = false;
+    unsigned int num_files = orig_files < rebuilt_files ? orig_files : rebuilt_files;
 
-    fprintf(stderr, "Testing with file: %s\n", abs_path);
-    fprintf(stderr, "Original DLL: %s\n", original_dll);
-    fprintf(stderr, "Rebuilt DLL: %s\n", rebuilt_dll);
+    for (unsigned int f = 0; f < num_files; f++) {
+        unsigned int orig_channels = 0, rebuilt_channels = 0;
+        if (orig.Aud_GetNumberOfChannels) orig.Aud_GetNumberOfChannels(f, &orig_channels);
+        if (rebuilt.Aud_GetNumberOfChannels) rebuilt.Aud_GetNumberOfChannels(f, &rebuilt_channels);
+        if (orig_channels != rebuilt_channels) cmp.structure_match = false;
+        unsigned int num_channels = orig_channels < rebuilt_channels ? orig_channels : rebuilt_channels;
 
-    printf("[\n");
+        for (unsigned int c = 0; c < num_channels; c++) {
+            ChannelCompare ch;
+            ch.file_idx = f;
+            ch.channel_idx = c;
+            ch.orig_count = 0;
+            ch.rebuilt_count = 0;
+            diff_reset(ch.diff);
 
-    // Test original DLL
-    TestResult orig_result = test_dll(original_dll, "original", abs_path_w, abs_path);
-    print_json(orig_result);
+            ch.orig_ret = orig.Aud_GetChannelDataDoubles(f, c, NULL, &ch.orig_count);
+            ch.rebuilt_ret = rebuilt.Aud_GetChannelDataDoubles(f, c, NULL, &ch.rebuilt_count);
 
-    printf(",\n");
+            bool readable = ch.orig_ret == 0 && ch.rebuilt_ret == 0;
+            if (readable && (!buffer_reserve(orig_buf, ch.orig_count) ||
+                             !buffer_reserve(rebuilt_buf, ch.rebuilt_count))) {
+                // Not diffed, so it must not count as a match
+                fprintf(stderr, "ERROR: file %u channel %u (%u / %u samples) does not fit the "
+                        "compare buffers\n", f, c, ch.orig_count, ch.rebuilt_count);
+                cmp.structure_match = false;
+            } else if (readable) {
+                unsigned int orig_count = ch.orig_count;
+                unsigned int rebuilt_count = ch.rebuilt_count;
+                if (orig_count > 0) ch.orig_ret = orig.Aud_GetChannelDataDoubles(f, c, orig_buf.data, &orig_count);
+                if (rebuilt_count > 0) ch.rebuilt_ret = rebuilt.Aud_GetChannelDataDoubles(f, c, rebuilt_buf.data, &rebuilt_count);
+                if (ch.orig_ret == 0 && ch.rebuilt_ret == 0) {
+                    size_t n = orig_count < rebuilt_count ? orig_count : rebuilt_count;
+                    diff_samples(ch.diff, orig_buf.data, rebuilt_buf.data, n, 0);
+                    // A length mismatch diverges where the shorter channel ends
+                    if (orig_count != rebuilt_count && ch.diff.first_divergence == NO_DIVERGENCE) {
+                        ch.diff.first_divergence = n;
+                    }
+                }
+            }
 
-    // Test rebuilt DLL
-    TestResult rebuilt_result = test_dll(rebuilt_dll, "rebuilt", abs_path_w, abs_path);
-    print_json(rebuilt_result);
+            if (ch.orig_ret != ch.rebuilt_ret || ch.orig_count != ch.rebuilt_count) {
+                cmp.structure_match = false;
+            }
+            diff_merge(cmp.total, ch.diff);
+            cmp.channels.push_back(ch);
+        }
+    }
 
-    printf("\n]\n");
+    for (size_t i = 0; i < cmp.channels.size(); i++) {
+        if (cmp.channels[i].diff.first_divergence != NO_DIVERGENCE) {
+            cmp.first_divergence = &cmp.channels[i];
+            cmp.total.first_divergence = cmp.channels[i].diff.first_divergence;
+            break;
+        }
+    }
 
-    free(test_file_w);
+    if (orig.Aud_CloseGetFile) orig.Aud_CloseGetFile();
+    if (rebuilt.Aud_CloseGetFile) rebuilt.Aud_CloseGetFile();
+    return cmp;
+}
 
-    // Check for parity
+// Compare one file's results; reports mismatches to stderr
+bool check_parity(const TestResult& orig_result, const TestResult& rebuilt_result,
+                  const CompareResult& cmp, unsigned long long max_ulp,
+                  const AccessOrderResult* orders = NULL) {
     bool parity = true;
 
+    if (orig_result.oversized_channels || rebuilt_result.oversized_channels) {
+        fprintf(stderr, "FAIL: %u original / %u rebuilt channels exceed the host's %u-sample buffer "
+                "limit and were not compared\n", orig_result.oversized_channels,
+                rebuilt_result.oversized_channels, (unsigned)SAMPLE_BUFFER_MAX);
+        parity = false;
+    }
+    for (int o = 0; orders && orders->ran && o < ACCESS_ORDERS; o++) {
+        const OrderResult& r = orders->orders[o];
+        if (r.mismatches == 0) continue;
+        const ChannelRef& ref = orders->channels[r.first_mismatch];
+        fprintf(stderr, "MISMATCH: access order %s: %u of %u reads differ from the sequential "
+                "read, first at file %u channel %u\n", g_access_order_names[o], r.mismatches,
+                r.reads, ref.file_idx, ref.channel_idx);
+        parity = false;
+    }
+
     // Special case: Original DLL returns -28 (needs MFC app hosting)
     // If original fails with -28 but rebuilt works (0), that's EXPECTED
     // We validate that rebuilt works correctly, not that they match
     if (orig_result.open_ret == -28 && rebuilt_result.open_ret == 0) {
+        if (!parity) return false;
         fprintf(stderr, "NOTE: Original DLL returns -28 (requires full host application context)\n");
         fprintf(stderr, "      Rebuilt DLL works standalone - this is EXPECTED behavior\n");
         fprintf(stderr, "      Validating rebuilt DLL returns correct values...\n\n");
@@ -295,11 +1000,10 @@ int main(int argc, char* argv[]) {
 
         if (parity) {
             fprintf(stderr, "[OK] Rebuilt DLL works correctly (original requires host context)\n");
-            return 0;
         } else {
             fprintf(stderr, "[FAIL] Rebuilt DLL validation failed\n");
-            return 1;
         }
+        return parity;
     }
 
     // Full parity check (when both DLLs can open files)
@@ -323,8 +1027,158 @@ int main(int argc, char* argv[]) {
                 orig_result.sample_count, rebuilt_result.sample_count);
         parity = false;
     }
+    if (parity && orig_result.total_channels != rebuilt_result.total_channels) {
+        fprintf(stderr, "MISMATCH: total_channels: original=%d, rebuilt=%d\n",
+                orig_result.total_channels, rebuilt_result.total_channels);
+        parity = false;
+    }
+    if (parity && cmp.ran && !cmp.structure_match) {
+        fprintf(stderr, "MISMATCH: channel layout or per-channel sample counts differ\n");
+        parity = false;
+    }
+    if (parity && cmp.ran && cmp.first_divergence && cmp.total.max_ulp > max_ulp) {
+        const ChannelCompare& ch = *cmp.first_divergence;
+        fprintf(stderr, "MISMATCH: samples: file %u channel %u diverges at sample %llu "
+                "(max_ulp=%llu, max_abs_error=%.17g, %llu of %llu samples differ)\n",
+                ch.file_idx, ch.channel_idx, (unsigned long long)ch.diff.first_divergence,
+                cmp.total.max_ulp, cmp.total.max_abs_error,
+                (unsigned long long)cmp.total.mismatched, (unsigned long long)cmp.total.samples);
+        parity = false;
+    }
+
+    return parity;
+}
+
+struct HostOptions {
+    int jobs;           // Worker processes for batch mode (1 = in-process)
+    int shard_index;    // >= 0 when running as a --shard worker
+    int shard_count;
+    unsigned int worker_timeout_ms;
+    unsigned long long max_ulp;     // Tolerated ULP distance per sample
+    bool use_simd;
+    bool scale;         // --scale benchmark instead of the parity check
+    bool access_orders; // Check out-of-order and partial channel reads
+    bool detect;        // Format index instead of the parity check
+    bool matrix;        // Full export matrix (parity_test.py JSON) instead of the parity check
+    unsigned int startup_runs;  // > 0: startup latency probes instead of the parity check
+    unsigned int alloc_soak_opens;  // > 0: allocation soak instead of the parity check
+    unsigned int soak_seconds;      // > 0: soak for this long instead of the parity check
+    unsigned int soak_interval;     // Seconds per soak sampling window
+    unsigned long long fuzz_iterations; // > 0: differential fuzzing instead of the parity check
+    unsigned long long fuzz_seed;
+    unsigned int fuzz_max_bytes;        // Larger corpus files are not used as seeds
+    const char* fuzz_out;               // Directory for finding inputs
+    bool roundtrip;     // Write round-trip benchmark instead of the parity check
+    unsigned int roundtrip_channels;
+    unsigned int roundtrip_samples; // Per channel
+    bool binary;        // --format binary: parity records as an AUD_RESULTS_MAGIC stream
+};
+
+// Workers log the stdout byte range of each file's records so the parent
+// can merge interleaved shards back into corpus order
+#define SHARD_FILE_LINE "Shard file: %ld %ld"
+
+// Run the given files in this process and write the JSON records (or the
+// binary record stream) to stdout. Workers (--shard) omit the enclosing
+// array and the separators between files, or the stream header and
+// summary, so the parent can splice them.
+int run_serial(const HostOptions& opts, const std::vector<std::string>& test_files, bool batch,
+               const char* original_dll, const char* rebuilt_dll) {
+    bool worker = opts.shard_index >= 0;
+
+    AudDll orig_dll, rebuilt_dll_h;
+    load_original_dll(orig_dll, original_dll);
+    load_dll(rebuilt_dll_h, rebuilt_dll, "rebuilt");
+    track_heap(orig_dll, 0);
+    track_heap(rebuilt_dll_h, 1);
+
+    SampleBuffer orig_buf = { NULL, 0 };
+    SampleBuffer rebuilt_buf = { NULL, 0 };
+
+    LatencyTotals orig_latency = {};
+    LatencyTotals rebuilt_latency = {};
+    MemoryTotals orig_memory = {};
+    MemoryTotals rebuilt_memory = {};
+
+    int passed = 0;
+    int failed = 0;
+
+    RecordWriter records = {};
+    bool binary = opts.binary && record_open(records, stdout, !worker);
+    if (!worker && !binary) printf("[\n");
+
+    for (size_t i = 0; i < test_files.size(); i++) {
+        // Get absolute path for test file
+        char abs_path[MAX_PATH];
+        GetFullPathNameA(test_files[i].c_str(), MAX_PATH, abs_path, NULL);
+        wchar_t abs_path_w[MAX_PATH];
+        MultiByteToWideChar(CP_UTF8, 0, abs_path, -1, abs_path_w, MAX_PATH);
+
+        fprintf(stderr, batch ? "\n=== Testing: %s ===\n" : "Testing with file: %s\n", abs_path);
+
+        TestResult orig_result = test_dll(orig_dll, abs_path_w, abs_path, orig_buf);
+        TestResult rebuilt_result = test_dll(rebuilt_dll_h, abs_path_w, abs_path, rebuilt_buf);
+        CompareResult cmp = compare_dlls(orig_dll, rebuilt_dll_h, abs_path_w, orig_buf, rebuilt_buf);
+
+        AccessOrderResult orders;
+        orders.ran = false;
+        if (opts.access_orders) orders = check_access_orders(rebuilt_dll_h, abs_path_w, rebuilt_buf);
+
+        bool file_passed = check_parity(orig_result, rebuilt_result, cmp, opts.max_ulp,
+                                        &orders);
+        long record_start = worker ? ftell(stdout) : 0;
+        if (binary) {
+            record_result(records, orig_result, 0);
+            record_result(records, rebuilt_result, 1);
+            record_compare(records, cmp, file_passed);
+            if (worker) record_flush(records);
+        } else {
+            if (i > 0 && !worker) printf(",\n");     // The parent separates workers' files
+            print_json(orig_result);
+            printf(",\n");
+            print_json(rebuilt_result, &cmp, &orders);
+            fflush(stdout);
+        }
+        if (worker) fprintf(stderr, SHARD_FILE_LINE "\n", record_start, ftell(stdout));
+
+        bool both_opened = orig_result.open_ret == 0 && rebuilt_result.open_ret == 0;
+        latency_add(orig_latency, orig_result, both_opened);
+        latency_add(rebuilt_latency, rebuilt_result, both_opened);
+        memory_add(orig_memory, orig_result);
+        memory_add(rebuilt_memory, rebuilt_result);
+
+        if (file_passed) {
+            passed++;
+        } else {
+            failed++;
+            if (batch) fprintf(stderr, "[FAIL] %s\n", abs_path);
+        }
+    }
+
+    if (binary) {
+        if (!worker) record_summary(records, passed, failed, 0, (unsigned)test_files.size());
+        record_close(records);
+    } else if (!worker) {
+        printf("\n]\n");
+    }
+
+    buffer_free(orig_buf);
+    buffer_free(rebuilt_buf);
+    unload_dll(orig_dll);
+    unload_dll(rebuilt_dll_h);
+
+    print_latency_table(orig_latency, rebuilt_latency);
+    print_memory_table(orig_memory, rebuilt_memory);
+
+    if (batch) {
+        fprintf(stderr, "\nBatch summary: %d passed, %d failed, %u files\n",
+                passed, failed, (unsigned)test_files.size());
+    }
+    if (worker) {
+        return failed == 0 ? 0 : 1;
+    }
 
-    if (parity) {
+    if (failed == 0) {
         fprintf(stderr, "\n[OK] PARITY CHECK PASSED\n");
         return 0;
     } else {
@@ -332,3 +1186,3184 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 }
+
+// Append a quoted argument to a CreateProcess command line
+void append_arg(std::string& cmd, const char* arg) {
+    if (!cmd.empty()) cmd += ' ';
+    cmd += '"';
+    cmd += arg;
+    cmd += '"';
+}
+
+// Copy a worker's captured output file to the given stream
+void replay_file(const char* path, FILE* out) {
+    FILE* f = NULL;
+    if (fopen_s(&f, path, "rb") != 0 || !f) return;
+    char buf[8192];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        fwrite(buf, 1, n, out);
+    }
+    fclose(f);
+}
+
+// Start a child process with stdout/stderr redirected to the two files
+bool spawn_child(const std::string& cmd, const char* out_path, const char* log_path,
+                 PROCESS_INFORMATION& pi) {
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), NULL, TRUE };
+    HANDLE out = CreateFileA(out_path, GENERIC_WRITE, FILE_SHARE_READ, &sa,
+                             CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    HANDLE err = CreateFileA(log_path, GENERIC_WRITE, FILE_SHARE_READ, &sa,
+                             CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (out == INVALID_HANDLE_VALUE || err == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "ERROR: Cannot create child output %s\n", out_path);
+        if (out != INVALID_HANDLE_VALUE) CloseHandle(out);
+        if (err != INVALID_HANDLE_VALUE) CloseHandle(err);
+        return false;
+    }
+
+    STARTUPINFOA si;
+    memset(&si, 0, sizeof(si));
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+    si.hStdOutput = out;
+    si.hStdError = err;
+
+    std::vector<char> cmd_buf(cmd.begin(), cmd.end());
+    cmd_buf.push_back('\0');
+    bool started = CreateProcessA(NULL, &cmd_buf[0], NULL, NULL, TRUE, 0, NULL, NULL,
+                                  &si, &pi) != 0;
+    CloseHandle(out);
+    CloseHandle(err);
+    return started;
+}
+
+// Wait for a child (terminating it after timeout_ms) and return its exit code
+DWORD wait_child(PROCESS_INFORMATION& pi, unsigned int timeout_ms) {
+    DWORD exit_code = (DWORD)-1;
+    if (WaitForSingleObject(pi.hProcess, timeout_ms) == WAIT_TIMEOUT) {
+        fprintf(stderr, "[TIMEOUT] child exceeded %u ms, terminating\n", timeout_ms);
+        TerminateProcess(pi.hProcess, (UINT)-1);
+        WaitForSingleObject(pi.hProcess, INFINITE);
+    }
+    GetExitCodeProcess(pi.hProcess, &exit_code);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+    return exit_code;
+}
+
+long file_length(const char* path) {
+    FILE* f = NULL;
+    long size = 0;
+    if (fopen_s(&f, path, "rb") == 0 && f) {
+        fseek(f, 0, SEEK_END);
+        size = ftell(f);
+        fclose(f);
+    }
+    return size;
+}
+
+struct Worker {
+    size_t count;       // Files k, k + jobs, k + 2 * jobs, ...
+    char json_path[MAX_PATH];
+    char log_path[MAX_PATH];
+    PROCESS_INFORMATION pi;
+    bool started;
+    bool ok;            // Exited cleanly with a summary and every file's record
+    std::vector<long> record_start;     // Output byte range of each file, from its log
+    std::vector<long> record_end;
+};
+
+// Copy bytes [start, end) of in to out
+static void copy_range(FILE* in, long start, long end, FILE* out) {
+    if (!in || fseek(in, start, SEEK_SET) != 0) return;
+    char buf[8192];
+    while (start < end) {
+        size_t n = fread(buf, 1, (size_t)std::min<long>(end - start, (long)sizeof(buf)), in);
+        if (n == 0) break;
+        fwrite(buf, 1, n, out);
+        start += (long)n;
+    }
+}
+
+// Launch one worker process per shard, file i going to worker i % jobs so
+// slow files spread across workers, then merge their records back into
+// corpus order. --timeout is one deadline for the whole batch.
+int run_parallel(const HostOptions& opts, const std::vector<std::string>& test_files,
+                 const char* original_dll, const char* rebuilt_dll, const char* target) {
+    char exe_path[MAX_PATH];
+    GetModuleFileNameA(NULL, exe_path, MAX_PATH);
+    char temp_dir[MAX_PATH];
+    GetTempPathA(MAX_PATH, temp_dir);
+
+    size_t jobs = (size_t)opts.jobs;
+    if (jobs > test_files.size()) jobs = test_files.size();
+
+    fprintf(stderr, "Parallel: %u workers\n", (unsigned)jobs);
+
+    std::vector<Worker> workers(jobs);
+    for (size_t k = 0; k < jobs; k++) {
+        Worker& w = workers[k];
+        memset(&w.pi, 0, sizeof(w.pi));
+        w.ok = false;
+        w.count = (test_files.size() - k + jobs - 1) / jobs;
+        sprintf_s(w.json_path, MAX_PATH, "%smfc_host_%lu_%u.json", temp_dir,
+                  GetCurrentProcessId(), (unsigned)k);
+        sprintf_s(w.log_path, MAX_PATH, "%smfc_host_%lu_%u.log", temp_dir,
+                  GetCurrentProcessId(), (unsigned)k);
+
+        char shard[32];
+        sprintf_s(shard, sizeof(shard), "%u/%u", (unsigned)k, (unsigned)jobs);
+        std::string cmd;
+        append_arg(cmd, exe_path);
+        append_arg(cmd, "--shard");
+        append_arg(cmd, shard);
+        char max_ulp[32];
+        sprintf_s(max_ulp, sizeof(max_ulp), "%llu", opts.max_ulp);
+        append_arg(cmd, "--max-ulp");
+        append_arg(cmd, max_ulp);
+        if (!opts.use_simd) append_arg(cmd, "--no-simd");
+        if (opts.access_orders) append_arg(cmd, "--access-orders");
+        if (opts.binary) {
+            append_arg(cmd, "--format");
+            append_arg(cmd, "binary");
+        }
+        append_arg(cmd, original_dll);
+        append_arg(cmd, rebuilt_dll);
+        append_arg(cmd, target);
+
+        w.started = spawn_child(cmd, w.json_path, w.log_path, w.pi);
+        if (!w.started) {
+            fprintf(stderr, "ERROR: Failed to start worker %u (error %lu)\n",
+                    (unsigned)k, GetLastError());
+        }
+    }
+
+    int passed = 0;
+    int failed = 0;
+    int crashed = 0;
+    bool first_record = true;
+
+    LONGLONG t_start = timer_now();
+    for (size_t k = 0; k < jobs; k++) {
+        Worker& w = workers[k];
+        DWORD exit_code = (DWORD)-1;
+        if (w.started) {
+            DWORD remaining = INFINITE;
+            if (opts.worker_timeout_ms != INFINITE) {
+                double left = opts.worker_timeout_ms - timer_ms(t_start, timer_now());
+                remaining = left > 0.0 ? (DWORD)left : 0;
+            }
+            if (WaitForSingleObject(w.pi.hProcess, remaining) == WAIT_TIMEOUT) {
+                fprintf(stderr, "[TIMEOUT] worker %u still running at the %u ms deadline, terminating\n",
+                        (unsigned)k, opts.worker_timeout_ms);
+                TerminateProcess(w.pi.hProcess, (UINT)-1);
+            }
+            exit_code = wait_child(w.pi, INFINITE);
+        }
+
+        // Replay the worker's log without its record offsets, which only
+        // the merge below needs
+        fprintf(stderr, "\n--- Worker %u: %u files, every %u from %u ---\n", (unsigned)k,
+                (unsigned)w.count, (unsigned)jobs, (unsigned)k);
+        int shard_passed = 0, shard_failed = 0, shard_files = 0;
+        bool have_summary = false;
+        FILE* log = NULL;
+        if (fopen_s(&log, w.log_path, "r") == 0 && log) {
+            char line[1024];
+            while (fgets(line, sizeof(line), log)) {
+                long start, end;
+                if (sscanf_s(line, SHARD_FILE_LINE, &start, &end) == 2) {
+                    w.record_start.push_back(start);
+                    w.record_end.push_back(end);
+                    continue;
+                }
+                fputs(line, stderr);
+                if (sscanf_s(line, "Batch summary: %d passed, %d failed, %d files",
+                             &shard_passed, &shard_failed, &shard_files) == 3) {
+                    have_summary = true;
+                }
+            }
+            fclose(log);
+        }
+
+        // A worker that crashed may have left a truncated record behind;
+        // drop its output and count the whole shard as failed.
+        w.ok = exit_code <= 1 && have_summary && w.record_start.size() == w.count;
+        if (w.ok) {
+            passed += shard_passed;
+            failed += shard_failed;
+        } else {
+            fprintf(stderr, "[FAIL] worker %u exited with 0x%08lx, %u files not verified\n",
+                    (unsigned)k, exit_code, (unsigned)w.count);
+            failed += (int)w.count;
+            crashed += (int)w.count;
+        }
+    }
+
+    // Interleave the workers' records back into corpus order
+    RecordWriter records = {};
+    bool binary = opts.binary && record_open(records, stdout, true);
+    if (!binary) printf("[\n");
+    std::vector<FILE*> outputs(jobs, (FILE*)NULL);
+    for (size_t k = 0; k < jobs; k++) {
+        if (workers[k].ok && fopen_s(&outputs[k], workers[k].json_path, "rb") != 0) outputs[k] = NULL;
+    }
+    for (size_t i = 0; i < test_files.size(); i++) {
+        size_t k = i % jobs;
+        size_t j = i / jobs;
+        if (!outputs[k]) continue;
+        if (binary) {
+            record_flush(records);
+        } else if (!first_record) {
+            printf(",\n");
+        }
+        fflush(stdout);
+        copy_range(outputs[k], workers[k].record_start[j], workers[k].record_end[j], stdout);
+        first_record = false;
+    }
+    for (size_t k = 0; k < jobs; k++) {
+        if (outputs[k]) fclose(outputs[k]);
+        DeleteFileA(workers[k].json_path);
+        DeleteFileA(workers[k].log_path);
+    }
+
+    if (binary) {
+        record_summary(records, passed, failed, crashed, (unsigned)test_files.size());
+        record_close(records);
+    } else {
+        printf("\n]\n");
+    }
+
+    fprintf(stderr, "\nBatch summary: %d passed, %d failed, %u files\n",
+            passed, failed, (unsigned)test_files.size());
+
+    if (failed == 0) {
+        fprintf(stderr, "\n[OK] PARITY CHECK PASSED\n");
+        return 0;
+    } else {
+        fprintf(stderr, "\n[FAIL] PARITY CHECK FAILED\n");
+        return 1;
+    }
+}
+
+// ============================================================================
+// Scaling benchmark (--scale)
+//
+// PeakWorkingSetSize is a per-process high-water mark, so each (file, DLL)
+// pair runs in its own probe process (this executable with --scale-probe).
+// The probe loads one DLL, reads every channel once and reports the timings
+// next to its memory counters; the parent splices the records into one
+// JSON array and prints a size-ordered table for plotting.
+// ============================================================================
+
+void print_json_scale(const TestResult& r, unsigned long long file_bytes,
+                      const MemorySnapshot& loaded, const MemorySnapshot& done,
+                      size_t buffer_bytes) {
+    unsigned long long samples = 0;
+    for (size_t i = 0; i < r.channels.size(); i++) {
+        if (r.channels[i].sample_count > 0) samples += (unsigned long long)r.channels[i].sample_count;
+    }
+    printf("  {\n");
+    printf("    \"dll\": \"%s\",\n", r.dll_name);
+    printf("    \"file\": ");
+    print_json_string(r.test_file.c_str());
+    printf(",\n");
+    printf("    \"file_bytes\": %llu,\n", file_bytes);
+    printf("    \"open_ret\": %d,\n", r.open_ret);
+    printf("    \"total_channels\": %d,\n", r.total_channels);
+    printf("    \"samples\": %llu,\n", samples);
+    printf("    \"open_ms\": %.4f,\n", r.open_ms);
+    printf("    \"size_query_ms\": %.4f,\n", r.size_query_ms);
+    printf("    \"read_ms\": %.4f,\n", r.read_ms);
+    printf("    \"close_ms\": %.4f,\n", r.close_ms);
+    printf("    \"loaded_working_set\": %llu,\n", loaded.working_set);
+    printf("    \"peak_working_set\": %llu,\n", done.peak_working_set);
+    printf("    \"peak_commit\": %llu,\n", done.peak_commit);
+    printf("    \"host_buffer_bytes\": %llu\n", (unsigned long long)buffer_bytes);
+    printf("  }");
+}
+
+int run_scale_probe(const char* which, const char* original_dll, const char* rebuilt_dll,
+                    const char* test_file) {
+    bool rebuilt = strcmp(which, "rebuilt") == 0;
+    char abs_path[MAX_PATH];
+    GetFullPathNameA(test_file, MAX_PATH, abs_path, NULL);
+    wchar_t abs_path_w[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, abs_path, -1, abs_path_w, MAX_PATH);
+
+    AudDll dll;
+    bool loaded_ok = rebuilt ? load_dll(dll, rebuilt_dll, "rebuilt") : load_original_dll(dll, original_dll);
+    if (!loaded_ok) {
+        fprintf(stderr, "ERROR: scale probe could not load the %s DLL\n", which);
+        return 1;
+    }
+    MemorySnapshot loaded = memory_snapshot();
+
+    SampleBuffer buf = { NULL, 0 };
+    TestResult r = test_dll(dll, abs_path_w, abs_path, buf);
+    MemorySnapshot done = memory_snapshot();
+
+    print_json_scale(r, file_size_bytes(abs_path_w), loaded, done, buf.capacity * sizeof(double));
+    fflush(stdout);
+    fprintf(stderr, "Scale probe: %.4f ms read, %llu peak working set\n",
+            r.read_ms, done.peak_working_set);
+
+    buffer_free(buf);
+    unload_dll(dll);
+    return r.open_ret == 0 && r.oversized_channels == 0 ? 0 : 1;
+}
+
+int run_scale(const HostOptions& opts, const std::vector<std::string>& test_files,
+              const char* original_dll, const char* rebuilt_dll) {
+    char exe_path[MAX_PATH];
+    GetModuleFileNameA(NULL, exe_path, MAX_PATH);
+    char temp_dir[MAX_PATH];
+    GetTempPathA(MAX_PATH, temp_dir);
+    char json_path[MAX_PATH];
+    char log_path[MAX_PATH];
+    sprintf_s(json_path, MAX_PATH, "%smfc_host_%lu_scale.json", temp_dir, GetCurrentProcessId());
+    sprintf_s(log_path, MAX_PATH, "%smfc_host_%lu_scale.log", temp_dir, GetCurrentProcessId());
+
+    static const char* const names[2] = { "original", "rebuilt" };
+    int failed = 0;
+    bool first_record = true;
+
+    printf("[\n");
+    fprintf(stderr, "\n%-40s %12s %12s %12s %12s %12s\n", "file", "MB",
+            "orig_ms", "rebuilt_ms", "orig_peakMB", "rebuilt_peakMB");
+
+    for (size_t i = 0; i < test_files.size(); i++) {
+        double read_ms[2] = { -1.0, -1.0 };
+        unsigned long long peak[2] = { 0, 0 };
+
+        for (int d = 0; d < 2; d++) {
+            std::string cmd;
+            append_arg(cmd, exe_path);
+            append_arg(cmd, "--scale-probe");
+            append_arg(cmd, names[d]);
+            append_arg(cmd, original_dll);
+            append_arg(cmd, rebuilt_dll);
+            append_arg(cmd, test_files[i].c_str());
+
+            PROCESS_INFORMATION pi;
+            DWORD exit_code = (DWORD)-1;
+            if (spawn_child(cmd, json_path, log_path, pi)) {
+                exit_code = wait_child(pi, opts.worker_timeout_ms);
+            }
+
+            FILE* log = NULL;
+            if (fopen_s(&log, log_path, "r") == 0 && log) {
+                char line[256];
+                while (fgets(line, sizeof(line), log)) {
+                    sscanf_s(line, "Scale probe: %lf ms read, %llu peak working set",
+                             &read_ms[d], &peak[d]);
+                }
+                fclose(log);
+            }
+
+            if (exit_code <= 1 && file_length(json_path) > 0) {
+                if (!first_record) printf(",\n");
+                fflush(stdout);
+                replay_file(json_path, stdout);
+                first_record = false;
+            } else {
+                fprintf(stderr, "[FAIL] %s probe exited with 0x%08lx: %s\n",
+                        names[d], exit_code, test_files[i].c_str());
+                replay_file(log_path, stderr);
+                failed++;
+            }
+        }
+
+        wchar_t path_w[MAX_PATH];
+        MultiByteToWideChar(CP_UTF8, 0, test_files[i].c_str(), -1, path_w, MAX_PATH);
+        const char* name = strrchr(test_files[i].c_str(), '\\');
+        name = name ? name + 1 : test_files[i].c_str();
+        fprintf(stderr, "%-40s %12.1f %12.2f %12.2f %12.1f %12.1f\n", name,
+                (double)file_size_bytes(path_w) / 1048576.0, read_ms[0], read_ms[1],
+                (double)peak[0] / 1048576.0, (double)peak[1] / 1048576.0);
+    }
+
+    printf("\n]\n");
+    DeleteFileA(json_path);
+    DeleteFileA(log_path);
+
+    fprintf(stderr, "\nScale summary: %u files, %d probes failed\n",
+            (unsigned)test_files.size(), failed);
+    return failed == 0 ? 0 : 1;
+}
+
+// ============================================================================
+// Startup latency (--startup N)
+//
+// Short-lived callers pay process start, MFC setup, LoadLibraryA and the
+// Aud_InitDll handshake before they see a single sample. Each probe process
+// (this executable with --startup-probe <dll>/<init>) loads one DLL, runs
+// the handshake, opens the first corpus file and reads channel 0 of file 0
+// through Aud_GetChannelDataDoubles, timing every step; the time since
+// process creation covers the loader and MFC as well. LoadLibraryA is also
+// timed on its own, with the private bytes it commits and the DLL image's
+// committed, resident and private (written) pages right after load and
+// after the first sample: work DllMain and static constructors do shows up
+// in the first set, lazily built tables move to the second. Both DLLs get
+// the three Aud_InitDll calls (init_dll_full), the only handshake they
+// export, and every probe must deliver the original's first sample.
+// ============================================================================
+
+struct StartupConfig {
+    const char* dll;
+    const char* init;
+};
+
+static const StartupConfig g_startup_configs[] = {
+    { "original", "full" },
+    { "rebuilt", "full" },
+};
+
+#define STARTUP_CONFIGS (sizeof(g_startup_configs) / sizeof(g_startup_configs[0]))
+
+struct StartupSample {
+    int init_ok;
+    int open_ret;
+    int read_ret;
+    unsigned int samples;       // Channel 0 sample count
+    double first_sample;
+    double load_ms;             // load_dll: LoadLibraryA + GetProcAddress
+    double load_library_ms;     // LoadLibraryA alone
+    long long load_commit;      // Private bytes committed by LoadLibraryA
+    ImagePages loaded;          // DLL image right after load_dll
+    ImagePages first;           // ... and once the first sample is in
+    double init_ms;
+    double open_ms;
+    double read_ms;             // Size query + read of channel 0
+    double since_start_ms;      // Process creation to first sample
+};
+
+#define STARTUP_LINE "Startup probe: %d %d %d %u %lf %lf %lf %lf %lf %lf %lf %lld %u %u %u %u %u %u"
+
+static double filetime_diff_ms(const FILETIME& from, const FILETIME& to) {
+    ULARGE_INTEGER a, b;
+    a.LowPart = from.dwLowDateTime;
+    a.HighPart = from.dwHighDateTime;
+    b.LowPart = to.dwLowDateTime;
+    b.HighPart = to.dwHighDateTime;
+    return (double)(long long)(b.QuadPart - a.QuadPart) / 10000.0;
+}
+
+int run_startup_probe(const char* spec, const char* original_dll, const char* rebuilt_dll,
+                      const char* test_file) {
+    bool rebuilt = strncmp(spec, "rebuilt/", 8) == 0;
+
+    char abs_path[MAX_PATH];
+    GetFullPathNameA(test_file, MAX_PATH, abs_path, NULL);
+    wchar_t abs_path_w[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, abs_path, -1, abs_path_w, MAX_PATH);
+    int format_code = get_format_code(abs_path_w);
+
+    StartupSample s = {};
+    s.open_ret = -1;
+    s.read_ret = -1;
+    AudDll dll;
+    LONGLONG t0 = timer_now();
+    if (!load_dll(dll, rebuilt ? rebuilt_dll : original_dll, rebuilt ? "rebuilt" : "original", false)) {
+        return 1;
+    }
+    LONGLONG t1 = timer_now();
+    s.load_ms = timer_ms(t0, t1);
+    s.load_library_ms = dll.load_ms;
+    s.load_commit = dll.load_commit;
+    s.loaded = image_pages(dll.module);
+    t1 = timer_now();
+
+    char message[256] = "";
+    s.init_ok = init_dll_full(dll, message, sizeof(message));
+    LONGLONG t2 = timer_now();
+    s.init_ms = timer_ms(t1, t2);
+
+    s.open_ret = dll.Aud_OpenGetFile(abs_path_w, format_code, 0);
+    LONGLONG t3 = timer_now();
+    s.open_ms = timer_ms(t2, t3);
+
+    SampleBuffer buf = { NULL, 0 };
+    if (s.open_ret == 0 && dll.Aud_GetChannelDataDoubles) {
+        s.read_ret = dll.Aud_GetChannelDataDoubles(0, 0, NULL, &s.samples);
+        if (s.read_ret == 0 && s.samples > 0 && buffer_reserve(buf, s.samples)) {
+            s.read_ret = dll.Aud_GetChannelDataDoubles(0, 0, buf.data, &s.samples);
+            if (s.read_ret == 0 && s.samples > 0) s.first_sample = buf.data[0];
+        }
+    }
+    s.read_ms = timer_ms(t3, timer_now());
+
+    FILETIME created, exited, kernel, user, now;
+    GetSystemTimePreciseAsFileTime(&now);
+    if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        s.since_start_ms = filetime_diff_ms(created, now);
+    }
+    s.first = image_pages(dll.module);
+
+    if (s.open_ret == 0 && dll.Aud_CloseGetFile) dll.Aud_CloseGetFile();
+    buffer_free(buf);
+    unload_dll(dll);
+
+    fprintf(stderr, "%s\n", message);
+    fprintf(stderr, "Startup probe: %d %d %d %u %.17g %.4f %.4f %.4f %.4f %.4f %.4f %lld %u %u %u %u %u %u\n",
+            s.init_ok, s.open_ret, s.read_ret, s.samples, s.first_sample, s.load_ms, s.init_ms,
+            s.open_ms, s.read_ms, s.since_start_ms, s.load_library_ms, s.load_commit,
+            s.loaded.committed, s.loaded.resident, s.loaded.private_pages, s.first.committed,
+            s.first.resident, s.first.private_pages);
+    return s.init_ok && s.open_ret == 0 && s.read_ret == 0 ? 0 : 1;
+}
+
+static double median_of(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+int run_startup(const HostOptions& opts, const std::vector<std::string>& test_files,
+                const char* original_dll, const char* rebuilt_dll) {
+    char exe_path[MAX_PATH];
+    GetModuleFileNameA(NULL, exe_path, MAX_PATH);
+    char temp_dir[MAX_PATH];
+    GetTempPathA(MAX_PATH, temp_dir);
+    char json_path[MAX_PATH];
+    char log_path[MAX_PATH];
+    sprintf_s(json_path, MAX_PATH, "%smfc_host_%lu_startup.json", temp_dir, GetCurrentProcessId());
+    sprintf_s(log_path, MAX_PATH, "%smfc_host_%lu_startup.log", temp_dir, GetCurrentProcessId());
+
+    if (test_files.empty()) {
+        fprintf(stderr, "ERROR: --startup needs at least one test file\n");
+        return 1;
+    }
+    const char* test_file = test_files[0].c_str();
+    fprintf(stderr, "Startup: %u probe(s) per path, first sample of %s\n", opts.startup_runs, test_file);
+
+    std::vector<double> dll_ms[STARTUP_CONFIGS], process_ms[STARTUP_CONFIGS], wall_ms[STARTUP_CONFIGS];
+    std::vector<double> init_ms[STARTUP_CONFIGS], load_library_ms[STARTUP_CONFIGS];
+    std::vector<double> private_loaded[STARTUP_CONFIGS], private_first[STARTUP_CONFIGS];
+    bool have_reference = false;
+    double reference = 0.0;
+    int failed = 0;
+    bool first_record = true;
+
+    printf("[\n");
+    for (size_t c = 0; c < STARTUP_CONFIGS; c++) {
+        const StartupConfig& cfg = g_startup_configs[c];
+        char spec[32];
+        sprintf_s(spec, sizeof(spec), "%s/%s", cfg.dll, cfg.init);
+
+        for (unsigned int run = 0; run < opts.startup_runs; run++) {
+            std::string cmd;
+            append_arg(cmd, exe_path);
+            append_arg(cmd, "--startup-probe");
+            append_arg(cmd, spec);
+            append_arg(cmd, original_dll);
+            append_arg(cmd, rebuilt_dll);
+            append_arg(cmd, test_file);
+
+            PROCESS_INFORMATION pi;
+            DWORD exit_code = (DWORD)-1;
+            LONGLONG t0 = timer_now();
+            if (spawn_child(cmd, json_path, log_path, pi)) {
+                exit_code = wait_child(pi, opts.worker_timeout_ms);
+            }
+            double wall = timer_ms(t0, timer_now());
+
+            StartupSample s = {};
+            bool parsed = false;
+            FILE* log = NULL;
+            if (fopen_s(&log, log_path, "r") == 0 && log) {
+                char line[512];
+                while (fgets(line, sizeof(line), log)) {
+                    if (sscanf_s(line, STARTUP_LINE, &s.init_ok, &s.open_ret, &s.read_ret, &s.samples,
+                                 &s.first_sample, &s.load_ms, &s.init_ms, &s.open_ms, &s.read_ms,
+                                 &s.since_start_ms, &s.load_library_ms, &s.load_commit,
+                                 &s.loaded.committed, &s.loaded.resident, &s.loaded.private_pages,
+                                 &s.first.committed, &s.first.resident, &s.first.private_pages) == 18) {
+                        parsed = true;
+                    }
+                }
+                fclose(log);
+            }
+
+            bool ok = exit_code == 0 && parsed;
+            if (ok) {
+                if (!have_reference) {
+                    reference = s.first_sample;
+                    have_reference = true;
+                } else if (memcmp(&reference, &s.first_sample, sizeof(double)) != 0) {
+                    fprintf(stderr, "[FAIL] %s first sample %.17g, expected %.17g\n", spec,
+                            s.first_sample, reference);
+                    ok = false;
+                }
+            }
+            if (!ok) {
+                fprintf(stderr, "[FAIL] %s probe %u exited with 0x%08lx\n", spec, run, exit_code);
+                replay_file(log_path, stderr);
+                failed++;
+            }
+
+            double to_first = s.load_ms + s.init_ms + s.open_ms + s.read_ms;
+            if (ok) {
+                load_library_ms[c].push_back(s.load_library_ms);
+                private_loaded[c].push_back(s.loaded.private_pages);
+                private_first[c].push_back(s.first.private_pages);
+                dll_ms[c].push_back(to_first);
+                process_ms[c].push_back(s.since_start_ms);
+                wall_ms[c].push_back(wall);
+                init_ms[c].push_back(s.init_ms);
+            }
+
+            if (!first_record) printf(",\n");
+            first_record = false;
+            printf("  {\"dll\": \"%s\", \"init\": \"%s\", \"run\": %u, \"exit_code\": %ld, \"ok\": %s, "
+                   "\"init_ok\": %s, \"open_ret\": %d, \"read_ret\": %d, \"samples\": %u, "
+                   "\"first_sample\": %.17g, \"load_ms\": %.4f, \"init_ms\": %.4f, \"open_ms\": %.4f, "
+                   "\"read_ms\": %.4f, \"dll_to_first_sample_ms\": %.4f, "
+                   "\"process_to_first_sample_ms\": %.4f, \"process_wall_ms\": %.4f, "
+                   "\"load_library_ms\": %.4f, \"load_commit_bytes\": %lld, "
+                   "\"image_pages_loaded\": {\"committed\": %u, \"resident\": %u, \"private\": %u}, "
+                   "\"image_pages_first_sample\": {\"committed\": %u, \"resident\": %u, \"private\": %u}}",
+                   cfg.dll, cfg.init, run, (long)exit_code, ok ? "true" : "false",
+                   s.init_ok ? "true" : "false", s.open_ret, s.read_ret, s.samples, s.first_sample,
+                   s.load_ms, s.init_ms, s.open_ms, s.read_ms, to_first, s.since_start_ms, wall,
+                   s.load_library_ms, s.load_commit, s.loaded.committed, s.loaded.resident,
+                   s.loaded.private_pages, s.first.committed, s.first.resident, s.first.private_pages);
+            fflush(stdout);
+        }
+    }
+    printf("\n]\n");
+    DeleteFileA(json_path);
+    DeleteFileA(log_path);
+
+    fprintf(stderr, "\nStartup latency (median ms over %u probes):\n", opts.startup_runs);
+    fprintf(stderr, "  %-18s %12s %10s %18s %18s %14s %14s\n", "path", "LoadLibraryA", "init",
+            "dll_to_first", "process_to_first", "process_wall", "private_pages");
+    for (size_t c = 0; c < STARTUP_CONFIGS; c++) {
+        if (dll_ms[c].empty()) continue;
+        char spec[32];
+        sprintf_s(spec, sizeof(spec), "%s/%s", g_startup_configs[c].dll, g_startup_configs[c].init);
+        char pages[32];
+        sprintf_s(pages, sizeof(pages), "%.0f -> %.0f", median_of(private_loaded[c]),
+                  median_of(private_first[c]));
+        fprintf(stderr, "  %-18s %12.4f %10.4f %18.4f %18.4f %14.4f %14s\n", spec,
+                median_of(load_library_ms[c]), median_of(init_ms[c]), median_of(dll_ms[c]),
+                median_of(process_ms[c]), median_of(wall_ms[c]), pages);
+    }
+
+    if (failed == 0) {
+        fprintf(stderr, "\n[OK] STARTUP CHECK PASSED\n");
+        return 0;
+    }
+    fprintf(stderr, "\n[FAIL] STARTUP CHECK FAILED: %d probe(s)\n", failed);
+    return 1;
+}
+
+// ============================================================================
+// Allocation soak (--alloc-soak N)
+//
+// Each Aud_OpenGetFile .. Aud_CloseGetFile cycle builds per-session state:
+// header strings behind Aud_GetString, the property structs handed out by
+// Aud_GetFileProperties / Aud_GetChannelProperties, text line buffers; close
+// must give all of it back. Each probe process (this executable with
+// --alloc-soak-probe <dll>) runs one warm-up pass over the corpus, then N
+// cycles round-robin over it: open, file and channel properties, both
+// strings, every channel (size query + read), the rebuilt DLL's text lines
+// for text formats, close. The DLL's own heap calls are counted through the
+// import hooks, and the process heaps are walked before and after the N
+// cycles for committed bytes, free blocks and fragmentation. A separate
+// process per DLL keeps one run's heap from shaping the next.
+//
+// The warm-up pass is the baseline: whatever the DLL sets up once has been
+// allocated by then. A DLL fails on:
+//   failed opens   any open that did not return 0, warm-up included
+//   regressions    files that opened in the warm-up pass and later did not
+//   heap leak      more than ALLOC_SOAK_MAX_OUTSTANDING of the DLL's heap
+//                  blocks left outstanding by the N cycles
+//   memory growth  private bytes up by more than ALLOC_SOAK_MAX_PRIVATE_GROWTH
+//   handle leak    more than ALLOC_SOAK_MAX_HANDLE_GROWTH handles over the
+//                  count after the warm-up pass
+// ============================================================================
+
+#define ALLOC_SOAK_MAX_OUTSTANDING      64
+#define ALLOC_SOAK_MAX_PRIVATE_GROWTH   (4ULL * 1024 * 1024)
+#define ALLOC_SOAK_MAX_HANDLE_GROWTH    8
+
+static const char* const g_alloc_soak_dlls[] = { "original", "rebuilt" };
+
+#define ALLOC_SOAK_DLLS (sizeof(g_alloc_soak_dlls) / sizeof(g_alloc_soak_dlls[0]))
+
+struct AllocSoakSample {
+    unsigned int opens;
+    unsigned int failed;        // Opens that did not return 0
+    unsigned int warm_failed;   // The same in the warm-up pass
+    unsigned int regressed;     // Failed opens of files the warm-up pass opened
+    HeapCounters heap;          // Over the N cycles, warm-up excluded
+    MemorySnapshot start;
+    MemorySnapshot end;
+    DWORD handles_start;
+    DWORD handles_end;
+    HeapWalkStats heap_start;
+    HeapWalkStats heap_end;
+    double elapsed_ms;
+};
+
+#define ALLOC_SOAK_LINE "Alloc soak probe: %u %u %u %u %lu %lu %lld %lld %lld %lld %llu %llu %llu " \
+                        "%llu %llu %llu %llu %llu %lf %lf %lf"
+
+static DWORD process_handle_count() {
+    DWORD handles = 0;
+    GetProcessHandleCount(GetCurrentProcess(), &handles);
+    return handles;
+}
+
+#define TEXT_LINE_MAX 4096
+
+// Digest of every line of a text file read through the DLL's text API
+static std::vector<unsigned long long> read_line_digests(const AudDll& dll, const wchar_t* path_w) {
+    std::vector<unsigned long long> digests;
+    int handle = dll.Aud_TextFileAOpenW(path_w, 0);
+    if (handle < 0) return digests;
+    char line[TEXT_LINE_MAX];
+    for (;;) {
+        memset(line, 0, sizeof(line));
+        if (dll.Aud_ReadLineAInFile(handle, line, sizeof(line)) < 0) break;
+        unsigned long long h = 14695981039346656037ULL;
+        for (const char* p = line; *p; p++) h = (h ^ (unsigned char)*p) * 1099511628211ULL;
+        digests.push_back(h);
+    }
+    dll.Aud_TextFileAClose(handle);
+    return digests;
+}
+
+// One full client cycle on one file; returns Aud_OpenGetFile's result
+static int alloc_soak_cycle(const AudDll& dll, const wchar_t* path_w, bool lines,
+                            SampleBuffer& buf) {
+    int ret = dll.Aud_OpenGetFile(path_w, get_format_code(path_w), 0);
+    if (ret == 0) {
+        unsigned char props[AUD_PROPS_SIZE];
+        char text[TEXT_LINE_MAX];
+        for (unsigned int id = 0; id < 2 && dll.Aud_GetString; id++) {
+            dll.Aud_GetString(id, text, sizeof(text) - 1);
+        }
+        unsigned int files_count = 1;
+        if (dll.Aud_GetNumberOfFiles) dll.Aud_GetNumberOfFiles(&files_count);
+        for (unsigned int f = 0; f < files_count; f++) {
+            if (dll.Aud_GetFileProperties) dll.Aud_GetFileProperties(f, props);
+            unsigned int channels_count = 0;
+            if (dll.Aud_GetNumberOfChannels) dll.Aud_GetNumberOfChannels(f, &channels_count);
+            for (unsigned int c = 0; c < channels_count; c++) {
+                if (dll.Aud_GetChannelProperties) dll.Aud_GetChannelProperties(f, c, props);
+                unsigned int count = 0;
+                if (dll.Aud_GetChannelDataDoubles(f, c, NULL, &count) == 0 && count > 0 &&
+                    buffer_reserve(buf, count)) {
+                    dll.Aud_GetChannelDataDoubles(f, c, buf.data, &count);
+                }
+            }
+        }
+        dll.Aud_CloseGetFile();
+    }
+    if (lines) read_line_digests(dll, path_w);
+    return ret;
+}
+
+int run_alloc_soak_probe(const HostOptions& opts, const char* spec,
+                         const std::vector<std::string>& test_files,
+                         const char* original_dll, const char* rebuilt_dll) {
+    bool rebuilt = strcmp(spec, "rebuilt") == 0;
+
+    AudDll dll;
+    bool loaded = rebuilt ? load_dll(dll, rebuilt_dll, "rebuilt") : load_original_dll(dll, original_dll);
+    if (!loaded || !dll.Aud_OpenGetFile || !dll.Aud_GetChannelDataDoubles || !dll.Aud_CloseGetFile) {
+        return 1;
+    }
+    track_heap(dll, 0);
+
+    std::vector<std::wstring> paths;
+    std::vector<bool> lines;
+    bool text_api = rebuilt && dll.Aud_TextFileAOpenW && dll.Aud_ReadLineAInFile &&
+                    dll.Aud_TextFileAClose;     // The original's text API hangs outside EASE
+    for (size_t i = 0; i < test_files.size(); i++) {
+        char abs_path[MAX_PATH];
+        GetFullPathNameA(test_files[i].c_str(), MAX_PATH, abs_path, NULL);
+        wchar_t abs_path_w[MAX_PATH];
+        MultiByteToWideChar(CP_UTF8, 0, abs_path, -1, abs_path_w, MAX_PATH);
+        paths.push_back(abs_path_w);
+        lines.push_back(text_api && is_text_format(abs_path_w));
+    }
+
+    AllocSoakSample s = {};
+    SampleBuffer buf = { NULL, 0 };
+    std::vector<int> warm_ret(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        warm_ret[i] = alloc_soak_cycle(dll, paths[i].c_str(), lines[i], buf);
+        if (warm_ret[i] != 0) s.warm_failed++;
+    }
+
+    s.start = memory_snapshot();
+    s.handles_start = process_handle_count();
+    s.heap_start = heap_walk_stats();
+    HeapCounters before = heap_counters(dll.heap_slot);
+    LONGLONG t0 = timer_now();
+    for (unsigned int n = 0; n < opts.alloc_soak_opens; n++) {
+        size_t i = n % paths.size();
+        if (alloc_soak_cycle(dll, paths[i].c_str(), lines[i], buf) != 0) {
+            s.failed++;
+            if (warm_ret[i] == 0) s.regressed++;
+        }
+        s.opens++;
+        if ((n + 1) % 10000 == 0) {
+            HeapCounters now = heap_counters_delta(heap_counters(dll.heap_slot), before);
+            fprintf(stderr, "%u opens, %lld heap blocks outstanding\n", n + 1, now.allocs - now.frees);
+        }
+    }
+    s.elapsed_ms = timer_ms(t0, timer_now());
+    s.heap = heap_counters_delta(heap_counters(dll.heap_slot), before);
+    s.heap_end = heap_walk_stats();         // Host buffer still held, as at the start
+    s.end = memory_snapshot();
+    s.handles_end = process_handle_count();
+    buffer_free(buf);
+    unload_dll(dll);
+
+    fprintf(stderr, "Alloc soak probe: %u %u %u %u %lu %lu %lld %lld %lld %lld %llu %llu %llu "
+            "%llu %llu %llu %llu %llu %.4f %.4f %.4f\n",
+            s.opens, s.failed, s.warm_failed, s.regressed, s.handles_start, s.handles_end,
+            s.heap.allocs, s.heap.reallocs, s.heap.frees, s.heap.alloc_bytes,
+            s.start.private_bytes, s.end.private_bytes, s.heap_start.committed_bytes,
+            s.heap_end.committed_bytes, s.heap_start.free_blocks, s.heap_end.free_blocks,
+            s.heap_end.largest_free, s.heap_end.free_bytes, s.heap_start.fragmentation_pct,
+            s.heap_end.fragmentation_pct, s.elapsed_ms);
+    return s.opens > 0 ? 0 : 1;     // The parent judges the sample
+}
+
+// Check one probe's sample against the limits above; returns the failed checks
+static int alloc_soak_verdict(const char* dll, const AllocSoakSample& s) {
+    int failed = 0;
+    if (s.warm_failed > 0 || s.failed > 0) {
+        fprintf(stderr, "[FAIL] %s: %u warm-up and %u of %u soak opens failed\n", dll,
+                s.warm_failed, s.failed, s.opens);
+        failed++;
+    }
+    if (s.regressed > 0) {
+        fprintf(stderr, "[FAIL] %s: %u opens failed on files that opened in the warm-up pass\n",
+                dll, s.regressed);
+        failed++;
+    }
+    long long outstanding = s.heap.allocs - s.heap.frees;
+    if (outstanding > ALLOC_SOAK_MAX_OUTSTANDING) {
+        fprintf(stderr, "[FAIL] %s: %lld heap blocks outstanding after the soak (limit %d)\n",
+                dll, outstanding, ALLOC_SOAK_MAX_OUTSTANDING);
+        failed++;
+    }
+    long long private_growth = (long long)s.end.private_bytes - (long long)s.start.private_bytes;
+    if (private_growth > (long long)ALLOC_SOAK_MAX_PRIVATE_GROWTH) {
+        fprintf(stderr, "[FAIL] %s: private bytes grew by %lld over the warm-up pass (limit %llu)\n",
+                dll, private_growth, ALLOC_SOAK_MAX_PRIVATE_GROWTH);
+        failed++;
+    }
+    long long handle_growth = (long long)s.handles_end - (long long)s.handles_start;
+    if (handle_growth > ALLOC_SOAK_MAX_HANDLE_GROWTH) {
+        fprintf(stderr, "[FAIL] %s: %lld more handles than after the warm-up pass (limit %d)\n",
+                dll, handle_growth, ALLOC_SOAK_MAX_HANDLE_GROWTH);
+        failed++;
+    }
+    return failed;
+}
+
+int run_alloc_soak(const HostOptions& opts, const std::vector<std::string>& test_files,
+                   const char* original_dll, const char* rebuilt_dll, const char* target) {
+    char exe_path[MAX_PATH];
+    GetModuleFileNameA(NULL, exe_path, MAX_PATH);
+    char temp_dir[MAX_PATH];
+    GetTempPathA(MAX_PATH, temp_dir);
+    char json_path[MAX_PATH];
+    char log_path[MAX_PATH];
+    sprintf_s(json_path, MAX_PATH, "%smfc_host_%lu_alloc.json", temp_dir, GetCurrentProcessId());
+    sprintf_s(log_path, MAX_PATH, "%smfc_host_%lu_alloc.log", temp_dir, GetCurrentProcessId());
+
+    if (test_files.empty()) {
+        fprintf(stderr, "ERROR: --alloc-soak needs at least one test file\n");
+        return 1;
+    }
+    char opens[16];
+    sprintf_s(opens, sizeof(opens), "%u", opts.alloc_soak_opens);
+    fprintf(stderr, "Alloc soak: %u opens per DLL over %u files\n",
+            opts.alloc_soak_opens, (unsigned)test_files.size());
+
+    bool ran[ALLOC_SOAK_DLLS] = {};
+    AllocSoakSample samples[ALLOC_SOAK_DLLS] = {};
+    int failed = 0;
+    bool first_record = true;
+
+    printf("[\n");
+    for (size_t c = 0; c < ALLOC_SOAK_DLLS; c++) {
+        const char* spec = g_alloc_soak_dlls[c];
+
+        std::string cmd;
+        append_arg(cmd, exe_path);
+        append_arg(cmd, "--alloc-soak");
+        append_arg(cmd, opens);
+        append_arg(cmd, "--alloc-soak-probe");
+        append_arg(cmd, spec);
+        append_arg(cmd, original_dll);
+        append_arg(cmd, rebuilt_dll);
+        append_arg(cmd, target);
+
+        PROCESS_INFORMATION pi;
+        DWORD exit_code = (DWORD)-1;
+        if (spawn_child(cmd, json_path, log_path, pi)) {
+            exit_code = wait_child(pi, opts.worker_timeout_ms);
+        }
+
+        AllocSoakSample& s = samples[c];
+        bool parsed = false;
+        FILE* log = NULL;
+        if (fopen_s(&log, log_path, "r") == 0 && log) {
+            char line[512];
+            while (fgets(line, sizeof(line), log)) {
+                if (sscanf_s(line, ALLOC_SOAK_LINE, &s.opens, &s.failed, &s.warm_failed,
+                             &s.regressed, &s.handles_start, &s.handles_end, &s.heap.allocs,
+                             &s.heap.reallocs, &s.heap.frees, &s.heap.alloc_bytes,
+                             &s.start.private_bytes, &s.end.private_bytes,
+                             &s.heap_start.committed_bytes, &s.heap_end.committed_bytes,
+                             &s.heap_start.free_blocks, &s.heap_end.free_blocks,
+                             &s.heap_end.largest_free, &s.heap_end.free_bytes,
+                             &s.heap_start.fragmentation_pct, &s.heap_end.fragmentation_pct,
+                             &s.elapsed_ms) == 21) {
+                    parsed = true;
+                }
+            }
+            fclose(log);
+        }
+        bool ok = exit_code == 0 && parsed;
+        if (!ok) {
+            fprintf(stderr, "[FAIL] %s probe exited with 0x%08lx\n", spec, exit_code);
+            replay_file(log_path, stderr);
+            failed++;
+        }
+        ran[c] = ok;
+        bool passed = ok;
+        if (ok) {
+            int checks = alloc_soak_verdict(spec, s);
+            failed += checks;
+            passed = checks == 0;
+        }
+
+        double per_open = s.opens ? 1.0 / s.opens : 0.0;
+        if (!first_record) printf(",\n");
+        first_record = false;
+        printf("  {\"dll\": \"%s\", \"exit_code\": %ld, \"ok\": %s, \"passed\": %s, \"opens\": %u, "
+               "\"failed_opens\": %u, \"warm_failed_opens\": %u, \"regressed_opens\": %u, "
+               "\"heap_calls_per_open\": %.3f, \"allocs_per_open\": %.3f, "
+               "\"frees_per_open\": %.3f, \"alloc_bytes_per_open\": %.1f, \"heap_outstanding\": %lld, "
+               "\"private_bytes_start\": %llu, \"private_bytes_end\": %llu, "
+               "\"handles_start\": %lu, \"handles_end\": %lu, \"heap_committed_start\": %llu, \"heap_committed_end\": %llu, "
+               "\"free_blocks_start\": %llu, \"free_blocks_end\": %llu, \"largest_free_end\": %llu, "
+               "\"fragmentation_pct_start\": %.2f, \"fragmentation_pct_end\": %.2f, \"elapsed_ms\": %.1f}",
+               spec, (long)exit_code, ok ? "true" : "false", passed ? "true" : "false", s.opens,
+               s.failed, s.warm_failed, s.regressed,
+               (double)(s.heap.allocs + s.heap.reallocs + s.heap.frees) * per_open,
+               (double)s.heap.allocs * per_open, (double)s.heap.frees * per_open,
+               (double)s.heap.alloc_bytes * per_open, s.heap.allocs - s.heap.frees,
+               s.start.private_bytes, s.end.private_bytes, s.handles_start, s.handles_end,
+               s.heap_start.committed_bytes,
+               s.heap_end.committed_bytes, s.heap_start.free_blocks, s.heap_end.free_blocks,
+               s.heap_end.largest_free, s.heap_start.fragmentation_pct, s.heap_end.fragmentation_pct,
+               s.elapsed_ms);
+        fflush(stdout);
+    }
+    printf("\n]\n");
+    DeleteFileA(json_path);
+    DeleteFileA(log_path);
+
+    fprintf(stderr, "\nAllocation soak (%u opens):\n", opts.alloc_soak_opens);
+    fprintf(stderr, "  %-16s %12s %14s %12s %16s %14s %14s\n", "dll", "calls/open", "bytes/open",
+            "outstanding", "private growth", "handle growth", "fragmentation");
+    for (size_t c = 0; c < ALLOC_SOAK_DLLS; c++) {
+        if (!ran[c]) continue;
+        const AllocSoakSample& s = samples[c];
+        char frag[32];
+        sprintf_s(frag, sizeof(frag), "%.1f%% -> %.1f%%", s.heap_start.fragmentation_pct,
+                  s.heap_end.fragmentation_pct);
+        fprintf(stderr, "  %-16s %12.2f %14.1f %12lld %16lld %14lld %14s\n", g_alloc_soak_dlls[c],
+                (double)(s.heap.allocs + s.heap.reallocs + s.heap.frees) / s.opens,
+                (double)s.heap.alloc_bytes / s.opens, s.heap.allocs - s.heap.frees,
+                (long long)(s.end.private_bytes - s.start.private_bytes),
+                (long long)s.handles_end - (long long)s.handles_start, frag);
+    }
+
+    if (failed == 0) {
+        fprintf(stderr, "\n[OK] ALLOC SOAK PASSED\n");
+        return 0;
+    }
+    fprintf(stderr, "\n[FAIL] ALLOC SOAK FAILED: %d check(s)\n", failed);
+    return 1;
+}
+
+// ============================================================================
+// Soak (--soak SECONDS)
+//
+// Services keep one DLL loaded for weeks, so slow leaks and tail-latency
+// drift matter more than any single call. One probe process per DLL (this
+// executable with --soak-probe <dll>; both run at the same time, so a soak
+// takes SECONDS, not twice that) loops open -> every channel -> close over
+// the corpus until SECONDS have passed. Aud_OpenGetFile, each channel's
+// Aud_GetChannelDataDoubles pair (size query + read) and Aud_CloseGetFile
+// go into HDR-style histograms, for the whole run and per --soak-interval
+// window. Each window also samples the process handle count, working set and
+// private bytes. The first window is the baseline, since it includes the
+// DLL's one-time setup. A probe fails on:
+//   handle leak   more than SOAK_HANDLE_SLACK handles over the first window
+//   memory creep  private bytes over the first window by SOAK_CREEP_PCT
+//                 percent and at least SOAK_CREEP_MIN_BYTES
+//   tail growth   median p99 of the last quarter of windows above
+//                 SOAK_TAIL_FACTOR times the first quarter's, and at least
+//                 SOAK_TAIL_MIN_MS more
+//   open failures files that opened in the warm-up pass and later did not
+// Only the rebuilt probe gates the run; the original's verdict is reported
+// for reference.
+// ============================================================================
+
+#define SOAK_MIN_WINDOWS        4       // Baseline plus quarters to compare
+#define SOAK_HANDLE_SLACK       16
+#define SOAK_CREEP_PCT          10.0
+#define SOAK_CREEP_MIN_BYTES    (16ULL * 1024 * 1024)
+#define SOAK_TAIL_FACTOR        2.0
+#define SOAK_TAIL_MIN_MS        0.1
+
+enum SoakOp { SOAK_OPEN, SOAK_READ, SOAK_CLOSE, SOAK_OPS };
+
+static const char* const g_soak_op_names[] = { "open", "read", "close" };
+
+struct SoakWindow {
+    double t_s;                 // Seconds since the timed loop started
+    unsigned long long cycles;  // Cumulative open/close cycles
+    DWORD handles;
+    MemorySnapshot mem;
+    double p99_ms[SOAK_OPS];
+    double max_ms[SOAK_OPS];
+};
+
+static double median_p99(const std::vector<SoakWindow>& windows, size_t first, size_t last, int op) {
+    std::vector<double> v;
+    for (size_t w = first; w < last; w++) v.push_back(windows[w].p99_ms[op]);
+    return median_of(v);
+}
+
+int run_soak_probe(const HostOptions& opts, const char* which,
+                   const std::vector<std::string>& test_files,
+                   const char* original_dll, const char* rebuilt_dll) {
+    bool rebuilt = strcmp(which, "rebuilt") == 0;
+    AudDll dll;
+    bool loaded = rebuilt ? load_dll(dll, rebuilt_dll, "rebuilt") : load_original_dll(dll, original_dll);
+    if (!loaded || !dll.Aud_OpenGetFile || !dll.Aud_GetChannelDataDoubles || !dll.Aud_CloseGetFile) {
+        return 1;
+    }
+
+    std::vector<std::wstring> paths;
+    std::vector<bool> opened;           // Warm-up pass result per file
+    SampleBuffer buf = { NULL, 0 };
+    for (size_t i = 0; i < test_files.size(); i++) {
+        char abs_path[MAX_PATH];
+        GetFullPathNameA(test_files[i].c_str(), MAX_PATH, abs_path, NULL);
+        wchar_t abs_path_w[MAX_PATH];
+        MultiByteToWideChar(CP_UTF8, 0, abs_path, -1, abs_path_w, MAX_PATH);
+        paths.push_back(abs_path_w);
+        bool ok = dll.Aud_OpenGetFile(abs_path_w, get_format_code(abs_path_w), 0) == 0;
+        if (ok) dll.Aud_CloseGetFile();
+        opened.push_back(ok);
+    }
+
+    static LatencyHistogram total[SOAK_OPS];
+    static LatencyHistogram window[SOAK_OPS];
+    for (int op = 0; op < SOAK_OPS; op++) {
+        latency_reset(total[op]);
+        latency_reset(window[op]);
+    }
+    std::vector<SoakWindow> windows;
+    unsigned long long cycles = 0;
+    unsigned long long failed_opens = 0;
+    unsigned long long open_regressions = 0;
+    DWORD handles_start = process_handle_count();
+    MemorySnapshot mem_start = memory_snapshot();
+
+    LONGLONG start = timer_now();
+    LONGLONG window_start = start;
+    double duration_ms = opts.soak_seconds * 1000.0;
+    double interval_ms = opts.soak_interval * 1000.0;
+    for (size_t i = 0; ; i = (i + 1) % paths.size()) {
+        const wchar_t* path_w = paths[i].c_str();
+        LONGLONG t0 = timer_now();
+        int ret = dll.Aud_OpenGetFile(path_w, get_format_code(path_w), 0);
+        LONGLONG t1 = timer_now();
+        latency_record(window[SOAK_OPEN], timer_ms(t0, t1));
+        if (ret == 0) {
+            unsigned int files_count = 1;
+            if (dll.Aud_GetNumberOfFiles) dll.Aud_GetNumberOfFiles(&files_count);
+            for (unsigned int f = 0; f < files_count; f++) {
+                unsigned int channels_count = 0;
+                if (dll.Aud_GetNumberOfChannels) dll.Aud_GetNumberOfChannels(f, &channels_count);
+                for (unsigned int c = 0; c < channels_count; c++) {
+                    LONGLONG r0 = timer_now();
+                    unsigned int count = 0;
+                    if (dll.Aud_GetChannelDataDoubles(f, c, NULL, &count) == 0 && count > 0 &&
+                        buffer_reserve(buf, count)) {
+                        dll.Aud_GetChannelDataDoubles(f, c, buf.data, &count);
+                    }
+                    latency_record(window[SOAK_READ], timer_ms(r0, timer_now()));
+                }
+            }
+            LONGLONG c0 = timer_now();
+            dll.Aud_CloseGetFile();
+            latency_record(window[SOAK_CLOSE], timer_ms(c0, timer_now()));
+        } else {
+            failed_opens++;
+            if (opened[i]) open_regressions++;
+        }
+        cycles++;
+
+        LONGLONG now = timer_now();
+        bool done = timer_ms(start, now) >= duration_ms;
+        if (timer_ms(window_start, now) >= interval_ms || done) {
+            SoakWindow w;
+            w.t_s = timer_ms(start, now) / 1000.0;
+            w.cycles = cycles;
+            w.handles = process_handle_count();
+            w.mem = memory_snapshot();
+            for (int op = 0; op < SOAK_OPS; op++) {
+                w.p99_ms[op] = latency_percentile_ms(window[op], 0.99);
+                w.max_ms[op] = (double)window[op].max_ns / 1e6;
+                latency_merge(total[op], window[op]);
+                latency_reset(window[op]);
+            }
+            windows.push_back(w);
+            fprintf(stderr, "%8.0f s  %10llu cycles  %6lu handles  %8llu KB private  "
+                    "p99 open %.3f read %.3f close %.3f ms\n", w.t_s, cycles, w.handles,
+                    w.mem.private_bytes / 1024, w.p99_ms[SOAK_OPEN], w.p99_ms[SOAK_READ],
+                    w.p99_ms[SOAK_CLOSE]);
+            window_start = now;
+        }
+        if (done) break;
+    }
+    buffer_free(buf);
+
+    // Verdict against the first window
+    const SoakWindow& base = windows.front();
+    const SoakWindow& last = windows.back();
+    long handle_growth = (long)last.handles - (long)base.handles;
+    long long private_growth = (long long)(last.mem.private_bytes - base.mem.private_bytes);
+    bool handle_leak = handle_growth > SOAK_HANDLE_SLACK;
+    bool memory_creep = private_growth > 0 &&
+                        (unsigned long long)private_growth >= SOAK_CREEP_MIN_BYTES &&
+                        (double)private_growth > (double)base.mem.private_bytes * SOAK_CREEP_PCT / 100.0;
+    bool tail_growth[SOAK_OPS] = {};
+    double early_p99[SOAK_OPS] = {};
+    double late_p99[SOAK_OPS] = {};
+    size_t quarter = std::max(windows.size() / 4, (size_t)1);
+    for (int op = 0; op < SOAK_OPS && windows.size() >= 2; op++) {
+        early_p99[op] = median_p99(windows, 0, quarter, op);
+        late_p99[op] = median_p99(windows, windows.size() - quarter, windows.size(), op);
+        tail_growth[op] = late_p99[op] > early_p99[op] * SOAK_TAIL_FACTOR &&
+                          late_p99[op] - early_p99[op] >= SOAK_TAIL_MIN_MS;
+    }
+    bool too_short = windows.size() < SOAK_MIN_WINDOWS;
+    bool ok = !too_short && !handle_leak && !memory_creep && open_regressions == 0 &&
+              !tail_growth[SOAK_OPEN] && !tail_growth[SOAK_READ] && !tail_growth[SOAK_CLOSE];
+
+    printf("  {\n");
+    printf("    \"dll\": \"%s\",\n", dll.dll_name);
+    printf("    \"duration_s\": %.1f,\n", last.t_s);
+    printf("    \"interval_s\": %u,\n", opts.soak_interval);
+    printf("    \"files\": %u,\n", (unsigned)paths.size());
+    printf("    \"cycles\": %llu,\n", cycles);
+    printf("    \"failed_opens\": %llu,\n", failed_opens);
+    printf("    \"open_regressions\": %llu,\n", open_regressions);
+    printf("    \"handles_start\": %lu,\n", handles_start);
+    printf("    \"handles_baseline\": %lu,\n", base.handles);
+    printf("    \"handles_end\": %lu,\n", last.handles);
+    printf("    \"private_bytes_start\": %llu,\n", mem_start.private_bytes);
+    printf("    \"private_bytes_baseline\": %llu,\n", base.mem.private_bytes);
+    printf("    \"private_bytes_end\": %llu,\n", last.mem.private_bytes);
+    printf("    \"peak_working_set\": %llu,\n", last.mem.peak_working_set);
+    for (int op = 0; op < SOAK_OPS; op++) {
+        printf("    \"%s\": ", g_soak_op_names[op]);
+        print_json_latency(total[op]);
+        printf(",\n");
+    }
+    printf("    \"windows\": [");
+    for (size_t w = 0; w < windows.size(); w++) {
+        const SoakWindow& s = windows[w];
+        printf("%s\n      {\"t_s\": %.1f, \"cycles\": %llu, \"handles\": %lu, \"working_set\": %llu, "
+               "\"private_bytes\": %llu", w ? "," : "", s.t_s, s.cycles, s.handles,
+               s.mem.working_set, s.mem.private_bytes);
+        for (int op = 0; op < SOAK_OPS; op++) {
+            printf(", \"%s_p99_ms\": %.6f, \"%s_max_ms\": %.6f", g_soak_op_names[op], s.p99_ms[op],
+                   g_soak_op_names[op], s.max_ms[op]);
+        }
+        printf("}");
+    }
+    printf("\n    ],\n");
+    printf("    \"tail_p99_ms\": {");
+    for (int op = 0; op < SOAK_OPS; op++) {
+        printf("%s\"%s\": [%.6f, %.6f]", op ? ", " : "", g_soak_op_names[op], early_p99[op], late_p99[op]);
+    }
+    printf("},\n");
+    printf("    \"handle_leak\": %s,\n", handle_leak ? "true" : "false");
+    printf("    \"memory_creep\": %s,\n", memory_creep ? "true" : "false");
+    printf("    \"tail_growth\": [");
+    bool first = true;
+    for (int op = 0; op < SOAK_OPS; op++) {
+        if (!tail_growth[op]) continue;
+        printf("%s\"%s\"", first ? "" : ", ", g_soak_op_names[op]);
+        first = false;
+    }
+    printf("],\n");
+    printf("    \"ok\": %s\n", ok ? "true" : "false");
+    printf("  }");
+    fflush(stdout);
+    unload_dll(dll);
+
+    if (too_short) {
+        fprintf(stderr, "[FAIL] %s: %u windows, the trend checks need at least %d\n", which,
+                (unsigned)windows.size(), SOAK_MIN_WINDOWS);
+    }
+    if (handle_leak) {
+        fprintf(stderr, "[FAIL] %s: %ld handles over the first window\n", which, handle_growth);
+    }
+    if (memory_creep) {
+        fprintf(stderr, "[FAIL] %s: private bytes grew %lld over the first window\n", which,
+                private_growth);
+    }
+    for (int op = 0; op < SOAK_OPS; op++) {
+        if (tail_growth[op]) {
+            fprintf(stderr, "[FAIL] %s: %s p99 grew from %.3f to %.3f ms\n", which,
+                    g_soak_op_names[op], early_p99[op], late_p99[op]);
+        }
+    }
+    if (open_regressions) {
+        fprintf(stderr, "[FAIL] %s: %llu opens failed on files that opened in the warm-up pass\n",
+                which, open_regressions);
+    }
+    fprintf(stderr, "Soak summary: %s %llu cycles %s\n", which, cycles, ok ? "ok" : "failed");
+    return ok ? 0 : 1;
+}
+
+int run_soak(const HostOptions& opts, const std::vector<std::string>& test_files,
+             const char* original_dll, const char* rebuilt_dll, const char* target) {
+    if (test_files.empty()) {
+        fprintf(stderr, "ERROR: --soak needs at least one test file\n");
+        return 1;
+    }
+    if (opts.soak_seconds < SOAK_MIN_WINDOWS * opts.soak_interval) {
+        fprintf(stderr, "ERROR: --soak %u with --soak-interval %u gives fewer than %d windows\n",
+                opts.soak_seconds, opts.soak_interval, SOAK_MIN_WINDOWS);
+        return 1;
+    }
+    char exe_path[MAX_PATH];
+    GetModuleFileNameA(NULL, exe_path, MAX_PATH);
+    char temp_dir[MAX_PATH];
+    GetTempPathA(MAX_PATH, temp_dir);
+
+    static const char* const dlls[] = { "original", "rebuilt" };
+    char json_path[2][MAX_PATH];
+    char log_path[2][MAX_PATH];
+    PROCESS_INFORMATION pi[2];
+    bool started[2];
+    char seconds[16], interval[16];
+    sprintf_s(seconds, sizeof(seconds), "%u", opts.soak_seconds);
+    sprintf_s(interval, sizeof(interval), "%u", opts.soak_interval);
+    fprintf(stderr, "Soak: %u s per DLL over %u files, %u s windows\n", opts.soak_seconds,
+            (unsigned)test_files.size(), opts.soak_interval);
+
+    for (int d = 0; d < 2; d++) {
+        sprintf_s(json_path[d], MAX_PATH, "%smfc_host_%lu_soak_%s.json", temp_dir,
+                  GetCurrentProcessId(), dlls[d]);
+        sprintf_s(log_path[d], MAX_PATH, "%smfc_host_%lu_soak_%s.log", temp_dir,
+                  GetCurrentProcessId(), dlls[d]);
+        std::string cmd;
+        append_arg(cmd, exe_path);
+        append_arg(cmd, "--soak");
+        append_arg(cmd, seconds);
+        append_arg(cmd, "--soak-interval");
+        append_arg(cmd, interval);
+        append_arg(cmd, "--soak-probe");
+        append_arg(cmd, dlls[d]);
+        append_arg(cmd, original_dll);
+        append_arg(cmd, rebuilt_dll);
+        append_arg(cmd, target);
+        started[d] = spawn_child(cmd, json_path[d], log_path[d], pi[d]);
+    }
+
+    int failed = 0;
+    bool first_record = true;
+    printf("[\n");
+    for (int d = 0; d < 2; d++) {
+        DWORD exit_code = started[d] ? wait_child(pi[d], opts.worker_timeout_ms) : (DWORD)-1;
+        fprintf(stderr, "\n--- Soak: %s ---\n", dlls[d]);
+        replay_file(log_path[d], stderr);
+
+        bool have_summary = false;
+        FILE* log = NULL;
+        if (fopen_s(&log, log_path[d], "r") == 0 && log) {
+            char line[256];
+            while (fgets(line, sizeof(line), log)) {
+                if (strncmp(line, "Soak summary:", 13) == 0) have_summary = true;
+            }
+            fclose(log);
+        }
+        if (exit_code <= 1 && have_summary && file_length(json_path[d]) > 0) {
+            if (!first_record) printf(",\n");
+            fflush(stdout);
+            replay_file(json_path[d], stdout);
+            first_record = false;
+        }
+        if (exit_code != 0 && d == 0) {
+            fprintf(stderr, "NOTE: original soak probe exited with 0x%08lx (reference only, "
+                    "not gated)\n", exit_code);
+        } else if (exit_code != 0) {
+            fprintf(stderr, "[FAIL] rebuilt soak probe exited with 0x%08lx\n", exit_code);
+            failed++;
+        }
+        DeleteFileA(json_path[d]);
+        DeleteFileA(log_path[d]);
+    }
+    printf("\n]\n");
+
+    if (failed == 0) {
+        fprintf(stderr, "\n[OK] SOAK PASSED\n");
+        return 0;
+    }
+    fprintf(stderr, "\n[FAIL] SOAK FAILED\n");
+    return 1;
+}
+
+// ============================================================================
+// Write round trip (--roundtrip)
+//
+// Each DLL writes the same synthetic multi-channel signal (one tone per
+// channel) as WAV and as ETM through Aud_OpenPutFile .. Aud_ClosePutFile,
+// in its own probe process (--roundtrip-probe) so the peak working set
+// covers that DLL's write path alone. The probe reads its file back with
+// the same DLL. The parent then decodes both DLLs' outputs with the original
+// DLL, which must see the same samples. Both DLLs see the same call
+// sequence: one Aud_PutChannelDataDoubles call per channel.
+// ============================================================================
+
+#define ROUNDTRIP_RATE 48000.0
+
+static const char* const g_roundtrip_exts[] = { ".wav", ".etm" };
+
+// Deterministic test signal, well inside full scale for every sample format
+static void roundtrip_signal(unsigned int channel, size_t offset, double* out, size_t n) {
+    double w = 2.0 * 3.14159265358979323846 * 100.0 * (channel + 1) / ROUNDTRIP_RATE;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = 0.5 * sin(w * (double)(offset + i));
+    }
+}
+
+struct RoundtripWrite {
+    int open_ret;
+    int channels_ret;
+    int props_ret;
+    int put_ret;                // First non-zero put result
+    int close_ret;
+    unsigned int put_calls;
+    double open_ms;
+    double put_ms;              // Sum over all put calls (signal generation excluded)
+    double close_ms;
+};
+
+RoundtripWrite write_roundtrip(const AudDll& dll, const wchar_t* path_w, unsigned int channels,
+                               unsigned int samples, SampleBuffer& buf) {
+    RoundtripWrite w = {};
+    w.open_ret = w.channels_ret = w.props_ret = w.put_ret = w.close_ret = -1000;
+    if (!dll.Aud_OpenPutFile || !dll.Aud_PutChannelDataDoubles || !dll.Aud_ClosePutFile) return w;
+    if (!buffer_reserve(buf, samples)) return w;
+
+    unsigned char props[AUD_PROPS_SIZE] = {};
+    double rate = ROUNDTRIP_RATE;
+    memcpy(props, &rate, sizeof(rate));
+
+    DeleteFileW(path_w);
+    LONGLONG t0 = timer_now();
+    w.open_ret = dll.Aud_OpenPutFile(path_w, format_from_extension(path_w));
+    w.open_ms = timer_ms(t0, timer_now());
+    if (w.open_ret != 0) return w;
+
+    w.channels_ret = dll.Aud_PutNumberOfChannels ? dll.Aud_PutNumberOfChannels(channels) : 0;
+    w.props_ret = dll.Aud_PutFileProperties ? dll.Aud_PutFileProperties(0, props) : 0;
+    for (unsigned int c = 0; c < channels && dll.Aud_PutChannelProperties; c++) {
+        int ret = dll.Aud_PutChannelProperties(0, c, props);
+        if (ret != 0 && w.props_ret == 0) w.props_ret = ret;
+    }
+
+    w.put_ret = 0;
+    for (unsigned int c = 0; c < channels && w.put_ret == 0; c++) {
+        roundtrip_signal(c, 0, buf.data, samples);
+        t0 = timer_now();
+        w.put_ret = dll.Aud_PutChannelDataDoubles(0, c, buf.data, samples);
+        w.put_ms += timer_ms(t0, timer_now());
+        w.put_calls++;
+    }
+
+    t0 = timer_now();
+    w.close_ret = dll.Aud_ClosePutFile();
+    w.close_ms = timer_ms(t0, timer_now());
+    return w;
+}
+
+struct RoundtripRead {
+    int open_ret;
+    unsigned int channels;
+    unsigned long long samples;
+    bool count_mismatch;        // Some channel came back with a different length
+    double max_abs_error;       // Against the written signal (sample format quantization)
+    double read_ms;
+};
+
+RoundtripRead read_roundtrip(const AudDll& dll, const wchar_t* path_w, unsigned int channels,
+                             unsigned int samples, SampleBuffer& buf, SampleBuffer& ref) {
+    RoundtripRead r = {};
+    LONGLONG t0 = timer_now();
+    r.open_ret = dll.Aud_OpenGetFile(path_w, get_format_code(path_w), 0);
+    if (r.open_ret != 0) return r;
+    if (dll.Aud_GetNumberOfChannels) dll.Aud_GetNumberOfChannels(0, &r.channels);
+    if (r.channels != channels) r.count_mismatch = true;
+    for (unsigned int c = 0; c < r.channels && c < channels; c++) {
+        unsigned int count = 0;
+        int ret = dll.Aud_GetChannelDataDoubles(0, c, NULL, &count);
+        if (ret == 0 && count > 0 && buffer_reserve(buf, count)) {
+            ret = dll.Aud_GetChannelDataDoubles(0, c, buf.data, &count);
+        }
+        if (ret != 0 || count != samples) r.count_mismatch = true;
+        if (ret != 0) continue;
+        r.samples += count;
+        unsigned int n = std::min(count, samples);
+        if (!buffer_reserve(ref, n)) continue;
+        roundtrip_signal(c, 0, ref.data, n);
+        for (unsigned int i = 0; i < n; i++) {
+            r.max_abs_error = std::max(r.max_abs_error, fabs(buf.data[i] - ref.data[i]));
+        }
+    }
+    dll.Aud_CloseGetFile();
+    r.read_ms = timer_ms(t0, timer_now());
+    return r;
+}
+
+// A peak less the host's one-channel signal buffer, i.e. what the DLL itself holds
+static unsigned long long without_host_buffer(unsigned long long peak, size_t buffer_bytes) {
+    return peak > buffer_bytes ? peak - buffer_bytes : 0;
+}
+
+void print_json_roundtrip(const AudDll& dll, const char* file, unsigned int channels,
+                          unsigned int samples, unsigned long long file_bytes,
+                          const RoundtripWrite& w, const RoundtripRead& r,
+                          const MemorySnapshot& loaded, const MemorySnapshot& written,
+                          size_t buffer_bytes) {
+    double write_ms = w.open_ms + w.put_ms + w.close_ms;
+    printf("  {\n");
+    printf("    \"dll\": \"%s\",\n", dll.dll_name);
+    printf("    \"file\": ");
+    print_json_string(file);
+    printf(",\n");
+    printf("    \"channels\": %u,\n", channels);
+    printf("    \"samples_per_channel\": %u,\n", samples);
+    printf("    \"file_bytes\": %llu,\n", file_bytes);
+    printf("    \"open_ret\": %d,\n", w.open_ret);
+    printf("    \"channels_ret\": %d,\n", w.channels_ret);
+    printf("    \"props_ret\": %d,\n", w.props_ret);
+    printf("    \"put_ret\": %d,\n", w.put_ret);
+    printf("    \"close_ret\": %d,\n", w.close_ret);
+    printf("    \"put_calls\": %u,\n", w.put_calls);
+    printf("    \"open_ms\": %.4f,\n", w.open_ms);
+    printf("    \"put_ms\": %.4f,\n", w.put_ms);
+    printf("    \"close_ms\": %.4f,\n", w.close_ms);
+    printf("    \"write_mb_per_s\": %.2f,\n",
+           write_ms > 0.0 ? (double)file_bytes / 1048576.0 / (write_ms / 1000.0) : 0.0);
+    printf("    \"loaded_working_set\": %llu,\n", loaded.working_set);
+    printf("    \"peak_working_set\": %llu,\n", written.peak_working_set);
+    printf("    \"peak_commit\": %llu,\n", written.peak_commit);
+    printf("    \"host_buffer_bytes\": %llu,\n", (unsigned long long)buffer_bytes);
+    printf("    \"write_peak_working_set\": %llu,\n", without_host_buffer(written.peak_working_set, buffer_bytes));
+    printf("    \"write_peak_commit\": %llu,\n", without_host_buffer(written.peak_commit, buffer_bytes));
+    printf("    \"readback\": {\"open_ret\": %d, \"channels\": %u, \"samples\": %llu, "
+           "\"count_mismatch\": %s, \"max_abs_error\": %.17g, \"read_ms\": %.4f}\n",
+           r.open_ret, r.channels, r.samples, r.count_mismatch ? "true" : "false",
+           r.max_abs_error, r.read_ms);
+    printf("  }");
+}
+
+// Probe: write one file with one DLL, read it back, print one record
+int run_roundtrip_probe(const HostOptions& opts, const char* which, const char* original_dll,
+                        const char* rebuilt_dll, const char* out_file) {
+    bool rebuilt = strcmp(which, "rebuilt") == 0;
+    wchar_t path_w[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, out_file, -1, path_w, MAX_PATH);
+
+    AudDll dll;
+    if (!(rebuilt ? load_dll(dll, rebuilt_dll, "rebuilt") : load_original_dll(dll, original_dll))) {
+        return 1;
+    }
+    MemorySnapshot loaded = memory_snapshot();
+
+    SampleBuffer buf = { NULL, 0 };
+    SampleBuffer ref = { NULL, 0 };
+    RoundtripWrite w = write_roundtrip(dll, path_w, opts.roundtrip_channels, opts.roundtrip_samples,
+                                       buf);
+    MemorySnapshot written = memory_snapshot();
+    size_t buffer_bytes = buf.capacity * sizeof(double);
+
+    RoundtripRead r = {};
+    r.open_ret = -1000;
+    if (w.close_ret == 0) {
+        r = read_roundtrip(dll, path_w, opts.roundtrip_channels, opts.roundtrip_samples, buf, ref);
+    }
+
+    print_json_roundtrip(dll, out_file, opts.roundtrip_channels, opts.roundtrip_samples,
+                         file_size_bytes(path_w), w, r, loaded, written, buffer_bytes);
+    fflush(stdout);
+    fprintf(stderr, "Roundtrip probe: %.4f ms write, %llu peak working set\n",
+            w.open_ms + w.put_ms + w.close_ms,
+            without_host_buffer(written.peak_working_set, buffer_bytes));
+
+    buffer_free(buf);
+    buffer_free(ref);
+    unload_dll(dll);
+    bool ok = w.put_ret == 0 && w.close_ret == 0 && r.open_ret == 0 && !r.count_mismatch;
+    return ok ? 0 : 1;
+}
+
+// Decode both outputs with the reference DLL and diff every channel
+static bool compare_outputs(const AudDll& dll, const wchar_t* a_w, const wchar_t* b_w,
+                            unsigned long long max_ulp, SampleDiff& total,
+                            SampleBuffer& a_buf, SampleBuffer& b_buf) {
+    diff_reset(total);
+    unsigned int channels_a = 0, channels_b = 0;
+    if (dll.Aud_OpenGetFile(a_w, get_format_code(a_w), 0) != 0) return false;
+    if (dll.Aud_GetNumberOfChannels) dll.Aud_GetNumberOfChannels(0, &channels_a);
+    dll.Aud_CloseGetFile();
+    if (dll.Aud_OpenGetFile(b_w, get_format_code(b_w), 0) != 0) return false;
+    if (dll.Aud_GetNumberOfChannels) dll.Aud_GetNumberOfChannels(0, &channels_b);
+    dll.Aud_CloseGetFile();
+    if (channels_a != channels_b) return false;
+
+    bool same = true;
+    for (unsigned int c = 0; c < channels_a; c++) {
+        unsigned int count_a = 0, count_b = 0;
+        int ret_a = -1000, ret_b = -1000;
+        if (dll.Aud_OpenGetFile(a_w, get_format_code(a_w), 0) == 0) {
+            ret_a = dll.Aud_GetChannelDataDoubles(0, c, NULL, &count_a);
+            if (ret_a == 0 && count_a > 0 && buffer_reserve(a_buf, count_a)) {
+                ret_a = dll.Aud_GetChannelDataDoubles(0, c, a_buf.data, &count_a);
+            }
+            dll.Aud_CloseGetFile();
+        }
+        if (dll.Aud_OpenGetFile(b_w, get_format_code(b_w), 0) == 0) {
+            ret_b = dll.Aud_GetChannelDataDoubles(0, c, NULL, &count_b);
+            if (ret_b == 0 && count_b > 0 && buffer_reserve(b_buf, count_b)) {
+                ret_b = dll.Aud_GetChannelDataDoubles(0, c, b_buf.data, &count_b);
+            }
+            dll.Aud_CloseGetFile();
+        }
+        if (ret_a != 0 || ret_b != 0 || count_a != count_b) {
+            same = false;
+            continue;
+        }
+        SampleDiff d;
+        diff_reset(d);
+        diff_samples(d, a_buf.data, b_buf.data, count_a, 0);
+        diff_merge(total, d);
+    }
+    return same && total.max_ulp <= max_ulp;
+}
+
+// Compare two files byte for byte
+static bool files_identical(const wchar_t* a_w, const wchar_t* b_w) {
+    FILE* a = NULL;
+    FILE* b = NULL;
+    bool same = _wfopen_s(&a, a_w, L"rb") == 0 && a && _wfopen_s(&b, b_w, L"rb") == 0 && b;
+    char buf_a[65536], buf_b[65536];
+    while (same) {
+        size_t na = fread(buf_a, 1, sizeof(buf_a), a);
+        size_t nb = fread(buf_b, 1, sizeof(buf_b), b);
+        if (na != nb || memcmp(buf_a, buf_b, na) != 0) same = false;
+        if (na == 0) break;
+    }
+    if (a) fclose(a);
+    if (b) fclose(b);
+    return same;
+}
+
+int run_roundtrip(const HostOptions& opts, const char* original_dll, const char* rebuilt_dll,
+                  const char* out_dir) {
+    char exe_path[MAX_PATH];
+    GetModuleFileNameA(NULL, exe_path, MAX_PATH);
+    char temp_dir[MAX_PATH];
+    GetTempPathA(MAX_PATH, temp_dir);
+    char json_path[MAX_PATH];
+    char log_path[MAX_PATH];
+    sprintf_s(json_path, MAX_PATH, "%smfc_host_%lu_roundtrip.json", temp_dir, GetCurrentProcessId());
+    sprintf_s(log_path, MAX_PATH, "%smfc_host_%lu_roundtrip.log", temp_dir, GetCurrentProcessId());
+
+    char channels_arg[32];
+    sprintf_s(channels_arg, sizeof(channels_arg), "%u", opts.roundtrip_channels);
+    char samples_arg[32];
+    sprintf_s(samples_arg, sizeof(samples_arg), "%u", opts.roundtrip_samples);
+
+    AudDll reference;
+    load_original_dll(reference, original_dll);
+    SampleBuffer a_buf = { NULL, 0 };
+    SampleBuffer b_buf = { NULL, 0 };
+
+    static const char* const names[2] = { "original", "rebuilt" };
+    int failed = 0;
+    bool first_record = true;
+
+    printf("[\n");
+    fprintf(stderr, "\nRound trip: %u channels x %u samples\n",
+            opts.roundtrip_channels, opts.roundtrip_samples);
+    fprintf(stderr, "(peaks exclude the host's signal buffer)\n");
+    fprintf(stderr, "%-6s %12s %12s %12s %12s %12s %12s %8s\n", "format", "MB", "orig_ms",
+            "rebuilt_ms", "orig_peakMB", "rebuilt_peakMB", "max_ulp", "parity");
+
+    for (size_t e = 0; e < sizeof(g_roundtrip_exts) / sizeof(g_roundtrip_exts[0]); e++) {
+        char out_path[2][MAX_PATH];
+        double write_ms[2] = { -1.0, -1.0 };
+        unsigned long long peak[2] = { 0, 0 };
+        bool probe_ok[2] = { false, false };
+
+        for (int d = 0; d < 2; d++) {
+            sprintf_s(out_path[d], MAX_PATH, "%s\\roundtrip_%s%s", out_dir, names[d],
+                      g_roundtrip_exts[e]);
+            std::string cmd;
+            append_arg(cmd, exe_path);
+            append_arg(cmd, "--roundtrip-channels");
+            append_arg(cmd, channels_arg);
+            append_arg(cmd, "--roundtrip-samples");
+            append_arg(cmd, samples_arg);
+            append_arg(cmd, "--roundtrip-probe");
+            append_arg(cmd, names[d]);
+            append_arg(cmd, original_dll);
+            append_arg(cmd, rebuilt_dll);
+            append_arg(cmd, out_path[d]);
+
+            PROCESS_INFORMATION pi;
+            DWORD exit_code = (DWORD)-1;
+            if (spawn_child(cmd, json_path, log_path, pi)) {
+                exit_code = wait_child(pi, opts.worker_timeout_ms);
+            }
+
+            FILE* log = NULL;
+            if (fopen_s(&log, log_path, "r") == 0 && log) {
+                char line[256];
+                while (fgets(line, sizeof(line), log)) {
+                    sscanf_s(line, "Roundtrip probe: %lf ms write, %llu peak working set",
+                             &write_ms[d], &peak[d]);
+                }
+                fclose(log);
+            }
+
+            probe_ok[d] = exit_code == 0;
+            if (exit_code <= 1 && file_length(json_path) > 0) {
+                if (!first_record) printf(",\n");
+                fflush(stdout);
+                replay_file(json_path, stdout);
+                first_record = false;
+            }
+            if (!probe_ok[d]) {
+                fprintf(stderr, "[FAIL] %s round trip exited with 0x%08lx: %s\n",
+                        names[d], exit_code, out_path[d]);
+                replay_file(log_path, stderr);
+            }
+        }
+
+        wchar_t orig_w[MAX_PATH], rebuilt_w[MAX_PATH];
+        MultiByteToWideChar(CP_UTF8, 0, out_path[0], -1, orig_w, MAX_PATH);
+        MultiByteToWideChar(CP_UTF8, 0, out_path[1], -1, rebuilt_w, MAX_PATH);
+        SampleDiff total;
+        diff_reset(total);
+        bool parity = probe_ok[0] && probe_ok[1] && reference.module &&
+                      compare_outputs(reference, orig_w, rebuilt_w, opts.max_ulp, total, a_buf, b_buf);
+        bool identical = parity && files_identical(orig_w, rebuilt_w);
+        if (!parity) failed++;
+
+        if (!first_record) printf(",\n");
+        printf("  {\"format\": \"%s\", \"compare\": {\"reader\": \"original\", \"parity\": %s, "
+               "\"bytes_identical\": %s, \"samples\": %llu, \"mismatched_samples\": %llu, "
+               "\"max_ulp\": %llu}}",
+               g_roundtrip_exts[e] + 1, parity ? "true" : "false", identical ? "true" : "false",
+               (unsigned long long)total.samples, (unsigned long long)total.mismatched, total.max_ulp);
+        first_record = false;
+
+        fprintf(stderr, "%-6s %12.1f %12.2f %12.2f %12.1f %12.1f %12llu %8s\n",
+                g_roundtrip_exts[e] + 1, (double)file_size_bytes(rebuilt_w) / 1048576.0,
+                write_ms[0], write_ms[1], (double)peak[0] / 1048576.0, (double)peak[1] / 1048576.0,
+                total.max_ulp, parity ? "ok" : "FAIL");
+    }
+
+    printf("\n]\n");
+    DeleteFileA(json_path);
+    DeleteFileA(log_path);
+    buffer_free(a_buf);
+    buffer_free(b_buf);
+    unload_dll(reference);
+
+    if (failed == 0) {
+        fprintf(stderr, "\n[OK] PARITY CHECK PASSED\n");
+        return 0;
+    }
+    fprintf(stderr, "\n[FAIL] PARITY CHECK FAILED\n");
+    return 1;
+}
+
+// ============================================================================
+// Format index (--detect)
+//
+// Classifies every file of the corpus from its first AUD_SNIFF_BYTES with
+// the host's table (sniff_format), without loading either DLL. One JSON
+// record per file, sorted by format, and per-format counts on stderr. The
+// index only reports: nothing here is compared, so it always exits 0.
+// ============================================================================
+
+struct DetectRecord {
+    const std::string* file;
+    int extension_format;
+    int format;
+    const char* family;
+    double sniff_ms;
+};
+
+static bool detect_before(const DetectRecord& a, const DetectRecord& b) {
+    if (a.format != b.format) return a.format < b.format;
+    return *a.file < *b.file;
+}
+
+int run_detect(const std::vector<std::string>& test_files) {
+    std::vector<DetectRecord> records;
+    double sniff_total = 0.0;
+    for (size_t i = 0; i < test_files.size(); i++) {
+        wchar_t path_w[MAX_PATH];
+        MultiByteToWideChar(CP_UTF8, 0, test_files[i].c_str(), -1, path_w, MAX_PATH);
+        DetectRecord r = { &test_files[i], format_from_extension(path_w), 0, NULL, 0.0 };
+        LONGLONG t0 = timer_now();
+        r.format = sniff_format(path_w, &r.family);
+        r.sniff_ms = timer_ms(t0, timer_now());
+        sniff_total += r.sniff_ms;
+        records.push_back(r);
+    }
+    std::stable_sort(records.begin(), records.end(), detect_before);
+
+    printf("[");
+    for (size_t i = 0; i < records.size(); i++) {
+        const DetectRecord& r = records[i];
+        printf("%s\n  {\"file\": ", i ? "," : "");
+        print_json_string(r.file->c_str());
+        printf(", \"extension_format\": %d, \"format\": %d, \"family\": \"%s\", \"sniff_ms\": %.4f}",
+               r.extension_format, r.format, r.family, r.sniff_ms);
+    }
+    printf("\n]\n");
+
+    fprintf(stderr, "\n%8s %8s %8s  %s\n", "format", "files", "renamed", "family");
+    for (size_t i = 0; i < records.size();) {
+        size_t j = i;
+        unsigned int renamed = 0;
+        for (; j < records.size() && records[j].format == records[i].format; j++) {
+            if (records[j].format != records[j].extension_format) renamed++;
+        }
+        fprintf(stderr, "%8d %8u %8u  %s\n", records[i].format, (unsigned)(j - i), renamed,
+                records[i].family);
+        i = j;
+    }
+    fprintf(stderr, "\nDetect summary: %u files, %.3f ms\n", (unsigned)records.size(), sniff_total);
+    return 0;
+}
+
+// ============================================================================
+// Differential fuzzing (--fuzz)
+//
+// Both DLLs stay loaded for the whole run. Each execution mutates one seed
+// from the corpus (bit flips, interesting bytes and u32s biased towards the
+// header, truncation, block insert/delete, splices from another seed) and
+// runs it through both DLLs with the lean sequence of serial_digest():
+// open, every channel of every file_idx, close. Any
+// difference in return codes, channel layout or sample bits is a finding.
+//
+// The DLLs only open paths, so each mutated input is rewritten into one
+// scratch file per extension, closed again before the DLLs open it. The
+// file is created with FILE_ATTRIBUTE_TEMPORARY and stays in the cache, so
+// there is no file per execution and no process restart. Access violations
+// inside a DLL are caught with SEH and recorded as crash findings; the run
+// stops there, since the DLL's globals and heap are no longer trustworthy.
+// A watchdog thread saves an execution that runs past --timeout (10 s by
+// default) as a hang finding and ends the process, as the DLL call cannot
+// be unwound. Findings go to --fuzz-out (one file each, deduplicated by
+// outcome) and are summarised as JSON on stdout.
+// ============================================================================
+
+struct FuzzSeed {
+    std::string path;
+    std::wstring ext;
+    std::vector<unsigned char> data;
+};
+
+struct FuzzRng {
+    unsigned long long state;
+    unsigned int next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (unsigned int)(state >> 32);
+    }
+    size_t below(size_t n) { return n ? (size_t)next() % n : 0; }
+};
+
+// Offsets inside the header are picked half of the time: that is where the
+// parsers make their size and layout decisions
+static size_t fuzz_offset(FuzzRng& rng, size_t size) {
+    if (size > AUD_SNIFF_BYTES && rng.next() & 1) return rng.below(AUD_SNIFF_BYTES);
+    return rng.below(size);
+}
+
+static void fuzz_mutate(FuzzRng& rng, std::vector<unsigned char>& in, const std::vector<FuzzSeed>& seeds,
+                        size_t max_bytes) {
+    static const unsigned char bytes[] = { 0x00, 0x01, 0x7f, 0x80, 0xff };
+    const unsigned int words[] = { 0, 1, 0x7fffffffu, 0x80000000u, 0xffffffffu, 0x10000u,
+                                   (unsigned int)in.size(), (unsigned int)in.size() * 2 };
+    unsigned int stack = 1 + rng.next() % 4;
+    for (unsigned int m = 0; m < stack; m++) {
+        size_t size = in.size();
+        switch (rng.next() % 8) {
+        case 0:
+        case 1:
+            if (size) in[fuzz_offset(rng, size)] ^= (unsigned char)(1u << (rng.next() % 8));
+            break;
+        case 2:
+            if (size) in[fuzz_offset(rng, size)] = bytes[rng.below(sizeof(bytes))];
+            break;
+        case 3:
+            if (size >= 4) {
+                size_t off = fuzz_offset(rng, size - 3) & ~(size_t)3;
+                unsigned int w = words[rng.below(sizeof(words) / sizeof(words[0]))];
+                memcpy(&in[off], &w, sizeof(w));
+            }
+            break;
+        case 4:
+            in.resize(rng.below(size + 1));
+            break;
+        case 5:
+            if (size) {
+                size_t off = rng.below(size);
+                size_t len = 1 + rng.below(std::min<size_t>(size - off, 4096));
+                std::vector<unsigned char> block(in.begin() + off, in.begin() + off + len);
+                in.insert(in.begin() + rng.below(size + 1), block.begin(), block.end());
+            }
+            break;
+        case 6:
+            if (size) {
+                size_t off = rng.below(size);
+                size_t len = 1 + rng.below(std::min<size_t>(size - off, 4096));
+                in.erase(in.begin() + off, in.begin() + off + len);
+            }
+            break;
+        default: {
+            const std::vector<unsigned char>& other = seeds[rng.below(seeds.size())].data;
+            if (!other.empty() && size) {
+                size_t src = rng.below(other.size());
+                size_t len = 1 + rng.below(std::min<size_t>(other.size() - src, 4096));
+                size_t dst = rng.below(size);
+                if (dst + len > size) in.resize(dst + len);
+                memcpy(&in[dst], &other[src], len);
+            }
+            break;
+        }
+        }
+        if (in.size() > max_bytes) in.resize(max_bytes);
+    }
+}
+
+struct FuzzOutcome {
+    DWORD exception;        // SEH code, 0 = none
+    FileDigest digest;
+};
+
+static void fuzz_digest_into(const AudDll& dll, const wchar_t* path_w, SampleBuffer& buf,
+                             FileDigest* out) {
+    *out = serial_digest(dll, path_w, buf);
+}
+
+// No objects with destructors in here, so SEH can guard the DLL calls
+static DWORD fuzz_guarded(const AudDll& dll, const wchar_t* path_w, SampleBuffer& buf,
+                          FileDigest* out) {
+    DWORD code = 0;
+    __try {
+        fuzz_digest_into(dll, path_w, buf, out);
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        code = GetExceptionCode();
+    }
+    if (code == 0) return 0;
+    // An overflow used up the guard page; restore it outside the handler
+    if (code == EXCEPTION_STACK_OVERFLOW) _resetstkoflw();
+    __try {
+        dll.Aud_CloseGetFile();
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+    }
+    return code;
+}
+
+static FuzzOutcome fuzz_run(const AudDll& dll, const wchar_t* path_w, SampleBuffer& buf) {
+    FuzzOutcome o;
+    o.digest.open_ret = -1000;
+    o.exception = fuzz_guarded(dll, path_w, buf, &o.digest);
+    return o;
+}
+
+// Rewrite the scratch file with the next input and close it, so no writer
+// holds it open while the DLLs read it
+static bool fuzz_write(const wchar_t* path_w, const std::vector<unsigned char>& in) {
+    HANDLE h = CreateFileW(path_w, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_TEMPORARY, NULL);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    DWORD written = 0;
+    bool ok = in.empty() ||
+              (WriteFile(h, &in[0], (DWORD)in.size(), &written, NULL) && written == in.size());
+    CloseHandle(h);
+    return ok;
+}
+
+#define FUZZ_HANG_MS 10000      // Watchdog limit without --timeout
+
+// State shared with the watchdog thread. The main thread sets started,
+// exec and seed before arming and leaves input alone while armed.
+struct FuzzWatchdog {
+    HANDLE stop;
+    volatile LONG armed;
+    volatile LONG started;      // GetTickCount() when armed
+    unsigned long long exec;
+    const std::vector<unsigned char>* input;
+    const FuzzSeed* seed;
+    const char* out_dir;
+    DWORD timeout_ms;
+};
+
+DWORD WINAPI fuzz_watchdog(LPVOID arg) {
+    FuzzWatchdog& w = *(FuzzWatchdog*)arg;
+    while (WaitForSingleObject(w.stop, 100) == WAIT_TIMEOUT) {
+        if (!w.armed || GetTickCount() - (DWORD)w.started < w.timeout_ms) continue;
+        char ext[16];
+        WideCharToMultiByte(CP_UTF8, 0, w.seed->ext.c_str(), -1, ext, sizeof(ext), NULL, NULL);
+        char name[MAX_PATH];
+        sprintf_s(name, MAX_PATH, "%s\\hang_%llu%s", w.out_dir, w.exec, ext);
+        FILE* out = NULL;
+        if (fopen_s(&out, name, "wb") == 0 && out) {
+            if (!w.input->empty()) fwrite(&(*w.input)[0], 1, w.input->size(), out);
+            fclose(out);
+        }
+        fprintf(stderr, "FINDING: hang (no return after %lu ms) from %s -> %s\n",
+                w.timeout_ms, w.seed->path.c_str(), name);
+        printf("{\n  \"executions\": %llu,\n  \"hang\": {\"exec\": %llu, \"seed\": ", w.exec, w.exec);
+        print_json_string(w.seed->path.c_str());
+        printf(", \"input\": ");
+        print_json_string(name);
+        printf("}\n}\n");
+        fflush(stdout);
+        fprintf(stderr, "\n[FAIL] PARITY CHECK FAILED\n");
+        fflush(stderr);
+        TerminateProcess(GetCurrentProcess(), 1);
+    }
+    return 0;
+}
+
+static bool load_seed(const std::string& path, size_t max_bytes, FuzzSeed& seed) {
+    wchar_t path_w[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, path_w, MAX_PATH);
+    unsigned long long size = file_size_bytes(path_w);
+    if (size == 0 || size > max_bytes) return false;
+    FILE* f = NULL;
+    if (fopen_s(&f, path.c_str(), "rb") != 0 || !f) return false;
+    seed.path = path;
+    const wchar_t* ext = wcsrchr(path_w, L'.');
+    seed.ext = ext ? ext : L"";
+    seed.data.resize((size_t)size);
+    bool ok = fread(&seed.data[0], 1, seed.data.size(), f) == seed.data.size();
+    fclose(f);
+    return ok;
+}
+
+struct FuzzFinding {
+    std::string kind;       // "crash" or "divergence"
+    std::string signature;  // Outcome summary used for deduplication
+    std::string seed;
+    std::string saved;
+    unsigned long long exec;
+};
+
+int run_fuzz(const HostOptions& opts, const std::vector<std::string>& test_files,
+             const char* original_dll, const char* rebuilt_dll) {
+    std::vector<FuzzSeed> seeds;
+    for (size_t i = 0; i < test_files.size(); i++) {
+        FuzzSeed seed;
+        if (load_seed(test_files[i], opts.fuzz_max_bytes, seed)) {
+            seeds.push_back(seed);
+        } else {
+            fprintf(stderr, "NOTE: seed skipped (empty, unreadable or over %u bytes): %s\n",
+                    opts.fuzz_max_bytes, test_files[i].c_str());
+        }
+    }
+    if (seeds.empty()) {
+        fprintf(stderr, "ERROR: no usable fuzz seeds\n");
+        return 1;
+    }
+
+    AudDll dlls[2];
+    load_original_dll(dlls[0], original_dll);
+    load_dll(dlls[1], rebuilt_dll, "rebuilt");
+    if (!dlls[0].module || !dlls[1].module) {
+        unload_dll(dlls[0]);
+        unload_dll(dlls[1]);
+        return 1;
+    }
+    CreateDirectoryA(opts.fuzz_out, NULL);
+
+    // One scratch file per seed extension, rewritten for every execution
+    char temp_dir[MAX_PATH];
+    GetTempPathA(MAX_PATH, temp_dir);
+    std::vector<std::wstring> scratch_exts;
+    std::vector<std::wstring> scratch_paths;
+    std::vector<size_t> seed_scratch(seeds.size());
+    for (size_t i = 0; i < seeds.size(); i++) {
+        size_t s = 0;
+        while (s < scratch_exts.size() && _wcsicmp(scratch_exts[s].c_str(), seeds[i].ext.c_str()) != 0) {
+            s++;
+        }
+        if (s == scratch_exts.size()) {
+            char ext[16];
+            WideCharToMultiByte(CP_UTF8, 0, seeds[i].ext.c_str(), -1, ext, sizeof(ext), NULL, NULL);
+            char path[MAX_PATH];
+            sprintf_s(path, MAX_PATH, "%smfc_host_%lu_fuzz%s", temp_dir, GetCurrentProcessId(), ext);
+            wchar_t path_w[MAX_PATH];
+            MultiByteToWideChar(CP_UTF8, 0, path, -1, path_w, MAX_PATH);
+            if (!fuzz_write(path_w, std::vector<unsigned char>())) {
+                fprintf(stderr, "ERROR: cannot create fuzz scratch file (error %lu)\n", GetLastError());
+                return 1;
+            }
+            scratch_exts.push_back(seeds[i].ext);
+            scratch_paths.push_back(path_w);
+        }
+        seed_scratch[i] = s;
+    }
+
+    FuzzRng rng = { opts.fuzz_seed ? opts.fuzz_seed : 0x9E3779B97F4A7C15ULL };
+    SampleBuffer bufs[2] = { { NULL, 0 }, { NULL, 0 } };
+    std::vector<FuzzFinding> findings;
+    std::vector<unsigned char> input;
+    unsigned long long divergences = 0, crashes = 0, opened = 0, any_opened = 0, executed = 0;
+    bool write_failed = false;
+
+    FuzzWatchdog watchdog;
+    watchdog.stop = CreateEventA(NULL, TRUE, FALSE, NULL);
+    watchdog.armed = 0;
+    watchdog.started = 0;
+    watchdog.exec = 0;
+    watchdog.input = &input;
+    watchdog.seed = &seeds[0];
+    watchdog.out_dir = opts.fuzz_out;
+    watchdog.timeout_ms = opts.worker_timeout_ms != INFINITE ? opts.worker_timeout_ms : FUZZ_HANG_MS;
+    HANDLE watchdog_thread = CreateThread(NULL, 0, fuzz_watchdog, &watchdog, 0, NULL);
+
+    fprintf(stderr, "Fuzzing: %u seeds, %llu executions, seed 0x%llx, hang limit %lu ms\n",
+            (unsigned)seeds.size(), opts.fuzz_iterations, rng.state, watchdog.timeout_ms);
+    LONGLONG t_start = timer_now();
+    LONGLONG t_report = t_start;
+
+    for (unsigned long long exec = 0; exec < opts.fuzz_iterations; exec++) {
+        size_t si = rng.below(seeds.size());
+        input = seeds[si].data;
+        fuzz_mutate(rng, input, seeds, opts.fuzz_max_bytes);
+        const wchar_t* path_w = scratch_paths[seed_scratch[si]].c_str();
+        if (!fuzz_write(path_w, input)) {
+            fprintf(stderr, "ERROR: cannot rewrite fuzz scratch file (error %lu)\n", GetLastError());
+            write_failed = true;
+            break;
+        }
+
+        watchdog.exec = exec;
+        watchdog.seed = &seeds[si];
+        InterlockedExchange(&watchdog.started, (LONG)GetTickCount());
+        InterlockedExchange(&watchdog.armed, 1);
+        FuzzOutcome o[2];
+        for (int d = 0; d < 2; d++) o[d] = fuzz_run(dlls[d], path_w, bufs[d]);
+        InterlockedExchange(&watchdog.armed, 0);
+        executed++;
+        if (o[0].digest.open_ret == 0 && o[1].digest.open_ret == 0) opened++;
+        if (o[0].digest.open_ret == 0 || o[1].digest.open_ret == 0) any_opened++;
+
+        bool crash = o[0].exception != 0 || o[1].exception != 0;
+        bool diverged = o[0].exception != o[1].exception || !digest_equal(o[0].digest, o[1].digest);
+        if (crash || diverged) {
+            crash ? crashes++ : divergences++;
+            char sig[160];
+            sprintf_s(sig, sizeof(sig), "exc %08lx/%08lx open %d/%d channels %u/%u",
+                      o[0].exception, o[1].exception, o[0].digest.open_ret, o[1].digest.open_ret,
+                      (unsigned)o[0].digest.channels.size(), (unsigned)o[1].digest.channels.size());
+            bool known = false;
+            for (size_t f = 0; f < findings.size() && !known; f++) {
+                known = findings[f].signature == sig;
+            }
+            if (!known) {
+                FuzzFinding f;
+                f.kind = crash ? "crash" : "divergence";
+                f.signature = sig;
+                f.seed = seeds[si].path;
+                f.exec = exec;
+                char name[MAX_PATH];
+                char ext[16];
+                WideCharToMultiByte(CP_UTF8, 0, seeds[si].ext.c_str(), -1, ext, sizeof(ext), NULL, NULL);
+                sprintf_s(name, MAX_PATH, "%s\\%s_%llu%s", opts.fuzz_out, f.kind.c_str(), exec, ext);
+                FILE* out = NULL;
+                if (fopen_s(&out, name, "wb") == 0 && out) {
+                    if (!input.empty()) fwrite(&input[0], 1, input.size(), out);
+                    fclose(out);
+                    f.saved = name;
+                }
+                fprintf(stderr, "FINDING: %s (%s) from %s -> %s\n", f.kind.c_str(), sig,
+                        f.seed.c_str(), f.saved.c_str());
+                findings.push_back(f);
+            }
+            if (crash) {
+                fprintf(stderr, "NOTE: stopping after the crash at exec %llu, the DLL state "
+                        "is no longer trustworthy\n", exec);
+                break;
+            }
+        }
+
+        LONGLONG now = timer_now();
+        if (timer_ms(t_report, now) >= 5000.0) {
+            double secs = timer_ms(t_start, now) / 1000.0;
+            fprintf(stderr, "  %llu execs, %.0f exec/s, %llu divergences, %llu crashes\n",
+                    exec + 1, (double)(exec + 1) / secs, divergences, crashes);
+            t_report = now;
+        }
+    }
+
+    double secs = timer_ms(t_start, timer_now()) / 1000.0;
+    SetEvent(watchdog.stop);
+    if (watchdog_thread) {
+        WaitForSingleObject(watchdog_thread, INFINITE);
+        CloseHandle(watchdog_thread);
+    }
+    CloseHandle(watchdog.stop);
+
+    printf("{\n");
+    printf("  \"executions\": %llu,\n", executed);
+    printf("  \"seconds\": %.3f,\n", secs);
+    printf("  \"exec_per_sec\": %.1f,\n", secs > 0.0 ? (double)executed / secs : 0.0);
+    printf("  \"both_opened\": %llu,\n", opened);
+    printf("  \"any_opened\": %llu,\n", any_opened);
+    printf("  \"divergences\": %llu,\n", divergences);
+    printf("  \"crashes\": %llu,\n", crashes);
+    printf("  \"findings\": [");
+    for (size_t f = 0; f < findings.size(); f++) {
+        printf("%s\n    {\"kind\": \"%s\", \"exec\": %llu, \"outcome\": ", f ? "," : "",
+               findings[f].kind.c_str(), findings[f].exec);
+        print_json_string(findings[f].signature.c_str());
+        printf(", \"seed\": ");
+        print_json_string(findings[f].seed.c_str());
+        printf(", \"input\": ");
+        print_json_string(findings[f].saved.c_str());
+        printf("}");
+    }
+    printf("%s]\n}\n", findings.empty() ? "" : "\n  ");
+
+    for (size_t s = 0; s < scratch_paths.size(); s++) DeleteFileW(scratch_paths[s].c_str());
+    buffer_free(bufs[0]);
+    buffer_free(bufs[1]);
+    unload_dll(dlls[0]);
+    unload_dll(dlls[1]);
+
+    fprintf(stderr, "\nFuzz summary: %llu execs in %.1f s (%.0f exec/s), %llu divergences, "
+            "%llu crashes, %u unique findings\n", executed, secs,
+            secs > 0.0 ? (double)executed / secs : 0.0, divergences, crashes,
+            (unsigned)findings.size());
+    if (executed > 0 && any_opened == 0) {
+        fprintf(stderr, "ERROR: neither DLL opened any fuzz input, the scratch files were never read\n");
+    }
+    if (findings.empty() && !write_failed && any_opened > 0) {
+        fprintf(stderr, "\n[OK] PARITY CHECK PASSED\n");
+        return 0;
+    }
+    fprintf(stderr, "\n[FAIL] PARITY CHECK FAILED\n");
+    return 1;
+}
+
+// ============================================================================
+// Export matrix (--matrix)
+//
+// One in-process pass over all 29 exports, in place of parity_test.py
+// (ctypes) and coverage_test_driver.cs (P/Invoke). The original DLL gets the
+// three-phase Aud_InitDll handshake once and the rebuilt the single
+// AUD_MAGIC call, as in parity_test.py; every test then calls both DLLs back
+// to back and records each export's result side by side. Outputs too large
+// to list (property blocks, samples, headers) are recorded as FNV-1a hashes.
+//
+// The JSON on stdout is parity_test.py's results/parity_results.json:
+// {timestamp, passed, failed, total, results: [{test, passed, details}]},
+// with the same "versions", "init" and "file_io_parity_<file>" tests (or
+// "file_io_rebuilt_<file>" when the handshake fails) plus "exports",
+// "put_path_<ext>", "text_file_<file>" and "errors". The original's text API
+// hangs outside EASE, so text_file_* holds the rebuilt DLL to itself: a
+// second pass after Aud_TextFileAClose must return the same lines.
+// ============================================================================
+
+static const char* const g_matrix_exports[] = {
+    "Aud_GetInterfaceVersion", "Aud_GetDllVersion", "Aud_InitDll",
+    "Aud_OpenGetFile", "Aud_CloseGetFile", "Aud_GetNumberOfFiles",
+    "Aud_GetNumberOfChannels", "Aud_FileExistsW",
+    "Aud_OpenPutFile", "Aud_ClosePutFile", "Aud_PutNumberOfChannels", "Aud_MakeDirW",
+    "Aud_GetChannelDataDoubles", "Aud_GetChannelDataOriginal",
+    "Aud_PutChannelDataDoubles", "Aud_PutChannelDataOriginal",
+    "Aud_GetFileProperties", "Aud_GetChannelProperties",
+    "Aud_PutFileProperties", "Aud_PutChannelProperties",
+    "Aud_GetFileHeaderOriginal", "Aud_PutFileHeaderOriginal",
+    "Aud_GetString", "Aud_PutString",
+    "Aud_TextFileAOpenW", "Aud_TextFileAClose", "Aud_ReadLineAInFile",
+    "Aud_GetLastWarnings", "Aud_GetErrDescription"
+};
+#define MATRIX_EXPORTS (sizeof(g_matrix_exports) / sizeof(g_matrix_exports[0]))
+
+// Error codes from TEST_MATRIX.md, for Aud_GetErrDescription
+static const int g_matrix_error_codes[] = {
+    0, -14, -28, 32772, (int)0x80070057, -2147024398, -2147024663
+};
+
+#define MATRIX_MISSING "\"missing\""     // Rendered result of an export the DLL lacks
+#define MATRIX_HEADER_MAX 65536         // Guarded buffer for Aud_GetFileHeaderOriginal
+#define MATRIX_HEADER_OVERFLOW -2000    // Rendered when the header ran into the guard page
+#define MATRIX_STRING_MAX 1024
+#define MATRIX_PUT_SAMPLES 4800
+
+struct MatrixTest {
+    std::string test;
+    bool passed;
+    std::vector<std::string> details;   // Rendered JSON objects
+};
+
+static std::string json_format(const char* fmt, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return buf;
+}
+
+static std::string json_quote(const char* s) {
+    std::string out = "\"";
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20 || c >= 0x80) {
+            out += json_format("\\u%04x", c);
+        } else {
+            out += (char)c;
+        }
+    }
+    return out + "\"";
+}
+
+static std::string json_bool(bool b) {
+    return b ? "true" : "false";
+}
+
+static std::string json_ret_count(int ret, unsigned int count) {
+    return json_format("{\"ret\": %d, \"count\": %u}", ret, count);
+}
+
+static std::string json_ret_text(int ret, const char* text) {
+    return json_format("{\"ret\": %d, \"value\": ", ret) + json_quote(text) + "}";
+}
+
+static std::string json_ret_hash(int ret, unsigned int calls, unsigned long long hash) {
+    return json_format("{\"ret\": %d, \"calls\": %u, \"hash\": \"%016llx\"}", ret, calls, hash);
+}
+
+static void matrix_detail(MatrixTest& t, const std::string& fields, bool match) {
+    t.details.push_back("{" + fields + ", \"match\": " + json_bool(match) + "}");
+    if (!match) t.passed = false;
+}
+
+// Both DLLs' rendered results for one export; they match when identical
+static void matrix_pair(MatrixTest& t, const char* function, const std::string& original,
+                        const std::string& rebuilt, const std::string& extra = std::string()) {
+    std::string fields = "\"function\": " + json_quote(function);
+    if (!extra.empty()) fields += ", " + extra;
+    fields += ", \"original\": " + original + ", \"rebuilt\": " + rebuilt;
+    matrix_detail(t, fields, original == rebuilt);
+}
+
+// Rebuilt DLL alone against an expected value (parity_test.py's rebuilt-only form)
+static void matrix_expect(MatrixTest& t, const char* function, const std::string& rebuilt,
+                          const std::string& expected, bool match,
+                          const std::string& extra = std::string()) {
+    std::string fields = "\"function\": " + json_quote(function);
+    if (!extra.empty()) fields += ", " + extra;
+    fields += ", \"rebuilt\": " + rebuilt + ", \"expected\": " + expected;
+    matrix_detail(t, fields, match);
+}
+
+static MatrixTest matrix_test(const std::string& name) {
+    MatrixTest t;
+    t.test = name;
+    t.passed = true;
+    return t;
+}
+
+static const char* base_name(const std::string& path) {
+    size_t slash = path.find_last_of("\\/");
+    return path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+MatrixTest matrix_versions(const AudDll& orig, const AudDll& rebuilt) {
+    MatrixTest t = matrix_test("versions");
+    matrix_pair(t, "Aud_GetInterfaceVersion", json_format("%.17g", orig.interface_version),
+                json_format("%.17g", rebuilt.interface_version));
+    matrix_pair(t, "Aud_GetDllVersion", json_format("%.17g", orig.dll_version),
+                json_format("%.17g", rebuilt.dll_version));
+    return t;
+}
+
+// Rebuilt: Aud_InitDll(AUD_MAGIC) as done by load_dll. Original: handshake.
+MatrixTest matrix_init(AudDll& orig, const AudDll& rebuilt, bool& orig_ok) {
+    MatrixTest t = matrix_test("init");
+    bool rebuilt_ok = rebuilt.session_magic != 0;
+    t.details.push_back(json_format("{\"function\": \"Aud_InitDll (simple)\", "
+                                    "\"rebuilt_magic\": \"0x%x\", \"rebuilt_ok\": ",
+                                    rebuilt.session_magic) + json_bool(rebuilt_ok) + "}");
+
+    char message[160] = "Original DLL not loaded";
+    orig_ok = orig.module && init_dll_full(orig, message, sizeof(message));
+    t.details.push_back("{\"function\": \"Aud_InitDll (full 3-phase)\", \"original_success\": " +
+                        json_bool(orig_ok) + ", \"original_message\": " + json_quote(message) + "}");
+    t.passed = rebuilt_ok && orig_ok;
+    return t;
+}
+
+MatrixTest matrix_exports(const AudDll& orig, const AudDll& rebuilt) {
+    MatrixTest t = matrix_test("exports");
+    for (size_t i = 0; i < MATRIX_EXPORTS; i++) {
+        bool o = orig.module && GetProcAddress(orig.module, g_matrix_exports[i]) != NULL;
+        bool r = rebuilt.module && GetProcAddress(rebuilt.module, g_matrix_exports[i]) != NULL;
+        matrix_pair(t, g_matrix_exports[i], json_bool(o), json_bool(r));
+    }
+    return t;
+}
+
+// Read-side exports on the open file, one rendered result each, in this order
+static const char* const g_matrix_read_exports[] = {
+    "Aud_GetFileProperties", "Aud_GetChannelProperties", "Aud_GetChannelDataDoubles",
+    "Aud_GetChannelDataOriginal", "Aud_GetFileHeaderOriginal", "Aud_GetString",
+    "Aud_GetLastWarnings"
+};
+#define MATRIX_READ_EXPORTS (sizeof(g_matrix_read_exports) / sizeof(g_matrix_read_exports[0]))
+
+// No objects with destructors in here, so SEH can guard the DLL call
+static int matrix_header_call(const AudDll& dll, unsigned int f, unsigned char* data,
+                              unsigned int* size) {
+    __try {
+        return dll.Aud_GetFileHeaderOriginal(f, data, size);
+    } __except (GetExceptionCode() == EXCEPTION_ACCESS_VIOLATION ? EXCEPTION_EXECUTE_HANDLER
+                                                                : EXCEPTION_CONTINUE_SEARCH) {
+        return MATRIX_HEADER_OVERFLOW;
+    }
+}
+
+// Aud_GetFileHeaderOriginal takes no buffer size and nothing documents a
+// maximum header, so the buffer ends at a no-access page: a header longer
+// than MATRIX_HEADER_MAX faults and is reported as MATRIX_HEADER_OVERFLOW
+// instead of silently overwriting the heap.
+static int matrix_read_header(const AudDll& dll, unsigned int f, std::vector<unsigned char>& raw,
+                              unsigned int& size) {
+    size = 0;
+    raw.clear();
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t page = si.dwPageSize;
+    size_t span = (MATRIX_HEADER_MAX + page - 1) / page * page;
+    unsigned char* base = (unsigned char*)VirtualAlloc(NULL, span + page, MEM_RESERVE | MEM_COMMIT,
+                                                       PAGE_READWRITE);
+    DWORD old_protect;
+    if (!base || !VirtualProtect(base + span, page, PAGE_NOACCESS, &old_protect)) {
+        if (base) VirtualFree(base, 0, MEM_RELEASE);
+        fprintf(stderr, "ERROR: cannot allocate the guarded header buffer (error %lu)\n", GetLastError());
+        return -1000;
+    }
+    unsigned char* data = base + span - MATRIX_HEADER_MAX;
+    int ret = matrix_header_call(dll, f, data, &size);
+    if (ret == MATRIX_HEADER_OVERFLOW) {
+        fprintf(stderr, "WARNING: %s Aud_GetFileHeaderOriginal wrote past a %u-byte buffer\n",
+                dll.dll_name, (unsigned)MATRIX_HEADER_MAX);
+        size = 0;
+    }
+    raw.assign(data, data + std::min(size, (unsigned int)MATRIX_HEADER_MAX));
+    VirtualFree(base, 0, MEM_RELEASE);
+    return ret;
+}
+
+static std::vector<std::string> matrix_file_reads(const AudDll& dll, SampleBuffer& buf,
+                                                  std::vector<unsigned char>& raw) {
+    unsigned int files_count = 1;
+    if (dll.Aud_GetNumberOfFiles) dll.Aud_GetNumberOfFiles(&files_count);
+
+    int file_props_ret = 0, chan_props_ret = 0, data_ret = 0, original_ret = 0, header_ret = 0;
+    unsigned int file_props_calls = 0, chan_props_calls = 0, original_calls = 0;
+    unsigned long long file_props_hash = DIGEST_BASIS, chan_props_hash = DIGEST_BASIS;
+    unsigned long long data_hash = DIGEST_BASIS, original_hash = DIGEST_BASIS;
+    unsigned long long header_hash = DIGEST_BASIS, samples = 0;
+    unsigned int header_bytes = 0;
+    unsigned char props[AUD_PROPS_SIZE];
+
+    for (unsigned int f = 0; f < files_count; f++) {
+        if (dll.Aud_GetFileProperties) {
+            memset(props, 0, sizeof(props));
+            int ret = dll.Aud_GetFileProperties(f, props);
+            if (ret != 0 && file_props_ret == 0) file_props_ret = ret;
+            file_props_hash = digest_bytes(props, sizeof(props), file_props_hash);
+            file_props_calls++;
+        }
+        if (dll.Aud_GetFileHeaderOriginal) {
+            unsigned int size = 0;
+            int ret = matrix_read_header(dll, f, raw, size);
+            if (ret != 0 && header_ret == 0) header_ret = ret;
+            if (!raw.empty()) header_hash = digest_bytes(&raw[0], raw.size(), header_hash);
+            header_bytes += size;
+        }
+
+        unsigned int channels_count = 0;
+        dll.Aud_GetNumberOfChannels(f, &channels_count);
+        for (unsigned int c = 0; c < channels_count; c++) {
+            if (dll.Aud_GetChannelProperties) {
+                memset(props, 0, sizeof(props));
+                int ret = dll.Aud_GetChannelProperties(f, c, props);
+                if (ret != 0 && chan_props_ret == 0) chan_props_ret = ret;
+                chan_props_hash = digest_bytes(props, sizeof(props), chan_props_hash);
+                chan_props_calls++;
+            }
+            ChannelDigest d = channel_digest(dll, f, c, buf);
+            if (d.ret != 0 && data_ret == 0) data_ret = d.ret;
+            data_hash = digest_bytes(&d.count, sizeof(d.count), data_hash);
+            data_hash = digest_bytes(&d.hash, sizeof(d.hash), data_hash);
+            samples += d.count;
+
+            // Room for the widest native sample type, zeroed so both DLLs hash alike
+            if (dll.Aud_GetChannelDataOriginal && d.ret == 0 && d.count > 0) {
+                raw.assign((size_t)d.count * sizeof(double), 0);
+                int ret = dll.Aud_GetChannelDataOriginal(f, c, (short*)&raw[0]);
+                if (ret != 0 && original_ret == 0) original_ret = ret;
+                original_hash = digest_bytes(&raw[0], raw.size(), original_hash);
+                original_calls++;
+            }
+        }
+    }
+
+    std::vector<std::string> out;
+    out.push_back(dll.Aud_GetFileProperties
+                  ? json_ret_hash(file_props_ret, file_props_calls, file_props_hash) : MATRIX_MISSING);
+    out.push_back(dll.Aud_GetChannelProperties
+                  ? json_ret_hash(chan_props_ret, chan_props_calls, chan_props_hash) : MATRIX_MISSING);
+    out.push_back(json_format("{\"ret\": %d, \"samples\": %llu, \"hash\": \"%016llx\"}",
+                              data_ret, samples, data_hash));
+    out.push_back(dll.Aud_GetChannelDataOriginal
+                  ? json_ret_hash(original_ret, original_calls, original_hash) : MATRIX_MISSING);
+    out.push_back(dll.Aud_GetFileHeaderOriginal
+                  ? json_format("{\"ret\": %d, \"size\": %u, \"hash\": \"%016llx\"}",
+                                header_ret, header_bytes, header_hash)
+                  : MATRIX_MISSING);
+
+    if (dll.Aud_GetString) {
+        std::string strings = "[";
+        char text[MATRIX_STRING_MAX];
+        for (unsigned int id = 0; id < 2; id++) {
+            memset(text, 0, sizeof(text));
+            int ret = dll.Aud_GetString(id, text, sizeof(text) - 1);
+            if (id > 0) strings += ", ";
+            strings += json_ret_text(ret, text);
+        }
+        out.push_back(strings + "]");
+    } else {
+        out.push_back(MATRIX_MISSING);
+    }
+    if (dll.Aud_GetLastWarnings) {
+        char text[MATRIX_STRING_MAX] = {};
+        int ret = dll.Aud_GetLastWarnings(text, sizeof(text) - 1);
+        out.push_back(json_ret_text(ret, text));
+    } else {
+        out.push_back(MATRIX_MISSING);
+    }
+    return out;
+}
+
+static std::string matrix_file_exists(const AudDll& dll, const wchar_t* path_w) {
+    return dll.Aud_FileExistsW ? json_format("%d", dll.Aud_FileExistsW(path_w)) : MATRIX_MISSING;
+}
+
+// parity_test.py test_file_io_parity, extended to every read-side export
+MatrixTest matrix_file_io_parity(const AudDll& orig, const AudDll& rebuilt, const std::string& file,
+                                 SampleBuffer& buf, std::vector<unsigned char>& raw) {
+    const char* name = base_name(file);
+    MatrixTest t = matrix_test(std::string("file_io_parity_") + name);
+    std::string file_field = "\"file\": " + json_quote(name);
+    wchar_t path_w[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, file.c_str(), -1, path_w, MAX_PATH);
+    int format_code = get_format_code(path_w);
+
+    matrix_pair(t, "Aud_FileExistsW", matrix_file_exists(orig, path_w),
+                matrix_file_exists(rebuilt, path_w), file_field);
+
+    int orig_open = orig.Aud_OpenGetFile(path_w, format_code, 0);
+    int rebuilt_open = rebuilt.Aud_OpenGetFile(path_w, format_code, 0);
+    std::string open_fields = file_field + json_format(", \"format_code\": %d", format_code);
+    if (orig_open != rebuilt_open && orig_open != 0) {
+        open_fields += json_format(", \"note\": \"Original DLL error %d - may need full host context\"",
+                                   orig_open);
+    }
+    matrix_pair(t, "Aud_OpenGetFile", json_format("%d", orig_open),
+                json_format("%d", rebuilt_open), open_fields);
+    if (orig_open != 0 || rebuilt_open != 0) {
+        if (orig_open == 0) orig.Aud_CloseGetFile();
+        if (rebuilt_open == 0) rebuilt.Aud_CloseGetFile();
+        return t;
+    }
+
+    unsigned int orig_files = 0, rebuilt_files = 0;
+    int orig_ret = orig.Aud_GetNumberOfFiles(&orig_files);
+    int rebuilt_ret = rebuilt.Aud_GetNumberOfFiles(&rebuilt_files);
+    matrix_pair(t, "Aud_GetNumberOfFiles", json_ret_count(orig_ret, orig_files),
+                json_ret_count(rebuilt_ret, rebuilt_files));
+
+    unsigned int orig_channels = 0, rebuilt_channels = 0;
+    orig_ret = orig.Aud_GetNumberOfChannels(0, &orig_channels);
+    rebuilt_ret = rebuilt.Aud_GetNumberOfChannels(0, &rebuilt_channels);
+    matrix_pair(t, "Aud_GetNumberOfChannels", json_ret_count(orig_ret, orig_channels),
+                json_ret_count(rebuilt_ret, rebuilt_channels));
+
+    std::vector<std::string> orig_reads = matrix_file_reads(orig, buf, raw);
+    std::vector<std::string> rebuilt_reads = matrix_file_reads(rebuilt, buf, raw);
+    for (size_t i = 0; i < MATRIX_READ_EXPORTS; i++) {
+        matrix_pair(t, g_matrix_read_exports[i], orig_reads[i], rebuilt_reads[i]);
+    }
+
+    matrix_pair(t, "Aud_CloseGetFile", json_format("%d", orig.Aud_CloseGetFile()),
+                json_format("%d", rebuilt.Aud_CloseGetFile()));
+    return t;
+}
+
+// parity_test.py test_file_io_rebuilt_only, used when the handshake fails
+MatrixTest matrix_file_io_rebuilt(const AudDll& rebuilt, const std::string& file) {
+    const char* name = base_name(file);
+    MatrixTest t = matrix_test(std::string("file_io_rebuilt_") + name);
+    wchar_t path_w[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, file.c_str(), -1, path_w, MAX_PATH);
+    int format_code = get_format_code(path_w);
+
+    int rebuilt_open = rebuilt.Aud_OpenGetFile(path_w, format_code, 0);
+    matrix_expect(t, "Aud_OpenGetFile", json_format("%d", rebuilt_open), "0", rebuilt_open == 0,
+                  "\"file\": " + json_quote(name) + json_format(", \"format_code\": %d", format_code));
+    if (rebuilt_open != 0) {
+        rebuilt.Aud_CloseGetFile();
+        return t;
+    }
+
+    unsigned int files = 0, channels = 0;
+    int ret = rebuilt.Aud_GetNumberOfFiles(&files);
+    matrix_expect(t, "Aud_GetNumberOfFiles", json_ret_count(ret, files), "{\"ret\": 0, \"count\": 1}",
+                  ret == 0 && files == 1);
+    ret = rebuilt.Aud_GetNumberOfChannels(0, &channels);
+    matrix_expect(t, "Aud_GetNumberOfChannels", json_ret_count(ret, channels),
+                  "{\"ret\": 0, \"count_gte\": 1}", ret == 0 && channels >= 1);
+    rebuilt.Aud_CloseGetFile();
+    return t;
+}
+
+struct MatrixTextPass {
+    int handle;
+    unsigned int lines;
+    unsigned long long hash;
+    int close_ret;
+};
+
+static MatrixTextPass matrix_text_pass(const AudDll& dll, const wchar_t* path_w) {
+    MatrixTextPass p = { -1, 0, DIGEST_BASIS, -1000 };
+    p.handle = dll.Aud_TextFileAOpenW(path_w, 0);
+    if (p.handle < 0) return p;
+    char line[TEXT_LINE_MAX];
+    for (;;) {
+        memset(line, 0, sizeof(line));
+        if (dll.Aud_ReadLineAInFile(p.handle, line, sizeof(line)) < 0) break;
+        p.hash = digest_bytes(line, strlen(line) + 1, p.hash);
+        p.lines++;
+    }
+    p.close_ret = dll.Aud_TextFileAClose(p.handle);
+    return p;
+}
+
+MatrixTest matrix_text_file(const AudDll& rebuilt, const std::string& file) {
+    const char* name = base_name(file);
+    MatrixTest t = matrix_test(std::string("text_file_") + name);
+    std::string file_field = "\"file\": " + json_quote(name) +
+                             ", \"note\": \"original text API hangs outside EASE\"";
+    wchar_t path_w[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, file.c_str(), -1, path_w, MAX_PATH);
+
+    MatrixTextPass first = matrix_text_pass(rebuilt, path_w);
+    matrix_expect(t, "Aud_TextFileAOpenW", json_format("%d", first.handle), "\">= 0\"",
+                  first.handle >= 0, file_field);
+    if (first.handle < 0) return t;
+    MatrixTextPass second = matrix_text_pass(rebuilt, path_w);
+    matrix_expect(t, "Aud_ReadLineAInFile",
+                  json_format("{\"lines\": %u, \"hash\": \"%016llx\"}", first.lines, first.hash),
+                  json_format("{\"lines\": %u, \"hash\": \"%016llx\"}", second.lines, second.hash),
+                  second.handle >= 0 && first.lines == second.lines && first.hash == second.hash);
+    matrix_expect(t, "Aud_TextFileAClose", json_format("%d", first.close_ret), "0",
+                  first.close_ret == 0);
+    return t;
+}
+
+// Put-side exports, one rendered result each, in this order
+static const char* const g_matrix_put_exports[] = {
+    "Aud_MakeDirW", "Aud_MakeDirW (existing)", "Aud_OpenPutFile", "Aud_PutNumberOfChannels",
+    "Aud_PutFileProperties", "Aud_PutChannelProperties", "Aud_PutChannelDataDoubles",
+    "Aud_PutChannelDataOriginal", "Aud_ClosePutFile", "Aud_PutString", "Aud_PutFileHeaderOriginal"
+};
+#define MATRIX_PUT_EXPORTS (sizeof(g_matrix_put_exports) / sizeof(g_matrix_put_exports[0]))
+#define MATRIX_PUT_CLOSE 8      // Index of "Aud_ClosePutFile" above
+
+static std::string matrix_ret(bool has_export, int ret) {
+    return has_export ? json_format("%d", ret) : MATRIX_MISSING;
+}
+
+// Two channels of MATRIX_PUT_SAMPLES at ROUNDTRIP_RATE: a double tone through
+// Aud_PutChannelDataDoubles and a 16-bit one through Aud_PutChannelDataOriginal,
+// in the property layout coverage_test_driver.cs uses. Aud_PutString and
+// Aud_PutFileHeaderOriginal follow the close, as they do there.
+static std::vector<std::string> matrix_put_path(const AudDll& dll, const wchar_t* dir_w,
+                                                const wchar_t* path_w, SampleBuffer& buf) {
+    std::vector<std::string> out;
+    out.push_back(matrix_ret(dll.Aud_MakeDirW != NULL, dll.Aud_MakeDirW ? dll.Aud_MakeDirW(dir_w) : 0));
+    out.push_back(matrix_ret(dll.Aud_MakeDirW != NULL, dll.Aud_MakeDirW ? dll.Aud_MakeDirW(dir_w) : 0));
+    char dir[MAX_PATH];
+    WideCharToMultiByte(CP_UTF8, 0, dir_w, -1, dir, MAX_PATH, NULL, NULL);
+    CreateDirectoryA(dir, NULL);
+
+    DeleteFileW(path_w);
+    int open_ret = dll.Aud_OpenPutFile ? dll.Aud_OpenPutFile(path_w, format_from_extension(path_w)) : 0;
+    out.push_back(matrix_ret(dll.Aud_OpenPutFile != NULL, open_ret));
+    if (!dll.Aud_OpenPutFile || open_ret != 0) {
+        while (out.size() < MATRIX_PUT_CLOSE) out.push_back("null");
+    } else {
+        unsigned char props[AUD_PROPS_SIZE] = {};
+        double rate = ROUNDTRIP_RATE;
+        unsigned int samples = MATRIX_PUT_SAMPLES, bits = 16;
+        memcpy(props, &rate, sizeof(rate));
+        memcpy(props + 12, &samples, sizeof(samples));
+        memcpy(props + 20, &bits, sizeof(bits));
+
+        out.push_back(matrix_ret(dll.Aud_PutNumberOfChannels != NULL,
+                                 dll.Aud_PutNumberOfChannels ? dll.Aud_PutNumberOfChannels(2) : 0));
+        out.push_back(matrix_ret(dll.Aud_PutFileProperties != NULL,
+                                 dll.Aud_PutFileProperties ? dll.Aud_PutFileProperties(0, props) : 0));
+        std::string chan_props = "[";
+        for (unsigned int c = 0; c < 2; c++) {
+            if (c > 0) chan_props += ", ";
+            chan_props += matrix_ret(dll.Aud_PutChannelProperties != NULL,
+                                     dll.Aud_PutChannelProperties
+                                     ? dll.Aud_PutChannelProperties(0, c, props) : 0);
+        }
+        out.push_back(chan_props + "]");
+
+        int ret = -1000;
+        if (dll.Aud_PutChannelDataDoubles && buffer_reserve(buf, MATRIX_PUT_SAMPLES)) {
+            roundtrip_signal(0, 0, buf.data, MATRIX_PUT_SAMPLES);
+            ret = dll.Aud_PutChannelDataDoubles(0, 0, buf.data, MATRIX_PUT_SAMPLES);
+        }
+        out.push_back(matrix_ret(dll.Aud_PutChannelDataDoubles != NULL, ret));
+
+        ret = -1000;
+        if (dll.Aud_PutChannelDataOriginal && buffer_reserve(buf, MATRIX_PUT_SAMPLES)) {
+            std::vector<short> pcm(MATRIX_PUT_SAMPLES);
+            roundtrip_signal(1, 0, buf.data, MATRIX_PUT_SAMPLES);
+            for (size_t i = 0; i < pcm.size(); i++) pcm[i] = (short)(buf.data[i] * 32000.0);
+            ret = dll.Aud_PutChannelDataOriginal(0, 1, &pcm[0], MATRIX_PUT_SAMPLES);
+        }
+        out.push_back(matrix_ret(dll.Aud_PutChannelDataOriginal != NULL, ret));
+    }
+    out.push_back(matrix_ret(dll.Aud_ClosePutFile != NULL, dll.Aud_ClosePutFile ? dll.Aud_ClosePutFile() : 0));
+
+    out.push_back(matrix_ret(dll.Aud_PutString != NULL,
+                             dll.Aud_PutString ? dll.Aud_PutString(0, "Test String Data") : 0));
+    unsigned char header[256] = {};
+    out.push_back(matrix_ret(dll.Aud_PutFileHeaderOriginal != NULL,
+                             dll.Aud_PutFileHeaderOriginal
+                             ? dll.Aud_PutFileHeaderOriginal(0, header, sizeof(header)) : 0));
+    return out;
+}
+
+// Both DLLs write the same file; the original must then decode both outputs
+// to the same samples.
+MatrixTest matrix_put(const AudDll& orig, const AudDll& rebuilt, const char* ext, const std::string& scratch, SampleBuffer& a_buf,
+                      SampleBuffer& b_buf) {
+    MatrixTest t = matrix_test(std::string("put_path_") + (ext + 1));
+    const AudDll* dlls[2] = { &orig, &rebuilt };
+    wchar_t dir_w[2][MAX_PATH], path_w[2][MAX_PATH];
+    std::vector<std::string> results[2];
+    for (int d = 0; d < 2; d++) {
+        std::string dir = scratch + "_" + dlls[d]->dll_name;
+        std::string path = dir + "\\matrix" + ext;
+        MultiByteToWideChar(CP_UTF8, 0, dir.c_str(), -1, dir_w[d], MAX_PATH);
+        MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, path_w[d], MAX_PATH);
+        results[d] = matrix_put_path(*dlls[d], dir_w[d], path_w[d], a_buf);
+    }
+    std::string ext_field = "\"format\": " + json_quote(ext + 1);
+    for (size_t i = 0; i < MATRIX_PUT_EXPORTS; i++) {
+        matrix_pair(t, g_matrix_put_exports[i], results[0][i], results[1][i], ext_field);
+    }
+
+    SampleDiff total;
+    diff_reset(total);
+    bool closed = results[0][MATRIX_PUT_CLOSE] == "0" && results[1][MATRIX_PUT_CLOSE] == "0";
+    bool parity = closed && compare_outputs(orig, path_w[0], path_w[1], 0, total, a_buf, b_buf);
+    matrix_detail(t, "\"function\": \"Aud_GetChannelDataDoubles (readback)\", " + ext_field +
+                     ", \"reader\": \"original\"" +
+                     json_format(", \"samples\": %llu, \"mismatched_samples\": %llu",
+                                 (unsigned long long)total.samples,
+                                 (unsigned long long)total.mismatched),
+                  parity);
+
+    for (int d = 0; d < 2; d++) {
+        DeleteFileW(path_w[d]);
+        char dir[MAX_PATH];
+        WideCharToMultiByte(CP_UTF8, 0, dir_w[d], -1, dir, MAX_PATH, NULL, NULL);
+        RemoveDirectoryA(dir);
+    }
+    return t;
+}
+
+static std::string matrix_err_description(const AudDll& dll, int code) {
+    if (!dll.Aud_GetErrDescription) return MATRIX_MISSING;
+    char text[MATRIX_STRING_MAX] = {};
+    int ret = dll.Aud_GetErrDescription(code, text, sizeof(text) - 1);
+    return json_ret_text(ret, text);
+}
+
+static std::string matrix_warnings(const AudDll& dll) {
+    if (!dll.Aud_GetLastWarnings) return MATRIX_MISSING;
+    char text[MATRIX_STRING_MAX] = {};
+    int ret = dll.Aud_GetLastWarnings(text, sizeof(text) - 1);
+    return json_ret_text(ret, text);
+}
+
+MatrixTest matrix_errors(const AudDll& orig, const AudDll& rebuilt, const std::string& scratch) {
+    MatrixTest t = matrix_test("errors");
+    for (size_t i = 0; i < sizeof(g_matrix_error_codes) / sizeof(g_matrix_error_codes[0]); i++) {
+        int code = g_matrix_error_codes[i];
+        matrix_pair(t, "Aud_GetErrDescription", matrix_err_description(orig, code),
+                    matrix_err_description(rebuilt, code), json_format("\"code\": %d", code));
+    }
+
+    // Nothing open: the not-found paths
+    std::string missing = scratch + "_missing\\nonexistent.wav";
+    wchar_t missing_w[MAX_PATH];
+    MultiByteToWideChar(CP_UTF8, 0, missing.c_str(), -1, missing_w, MAX_PATH);
+    matrix_pair(t, "Aud_FileExistsW", matrix_file_exists(orig, missing_w),
+                matrix_file_exists(rebuilt, missing_w), "\"file\": \"nonexistent.wav\"");
+    int orig_open = orig.Aud_OpenGetFile(missing_w, 9, 0);
+    int rebuilt_open = rebuilt.Aud_OpenGetFile(missing_w, 9, 0);
+    matrix_pair(t, "Aud_OpenGetFile", json_format("%d", orig_open), json_format("%d", rebuilt_open),
+                "\"file\": \"nonexistent.wav\"");
+    if (orig_open == 0) orig.Aud_CloseGetFile();
+    if (rebuilt_open == 0) rebuilt.Aud_CloseGetFile();
+    matrix_pair(t, "Aud_GetLastWarnings", matrix_warnings(orig), matrix_warnings(rebuilt));
+    return t;
+}
+
+static void print_matrix_summary(const MatrixTest& t) {
+    if (t.passed) {
+        fprintf(stderr, "  [OK] %s (%u checks)\n", t.test.c_str(), (unsigned)t.details.size());
+        return;
+    }
+    fprintf(stderr, "  [FAIL] %s\n", t.test.c_str());
+    for (size_t i = 0; i < t.details.size(); i++) {
+        if (t.details[i].find("\"match\": false") != std::string::npos) {
+            fprintf(stderr, "         %s\n", t.details[i].c_str());
+        }
+    }
+}
+
+int run_matrix(const std::vector<std::string>& test_files, const char* original_dll,
+               const char* rebuilt_dll) {
+    LONGLONG t0 = timer_now();
+    AudDll orig, rebuilt;
+    load_dll(orig, original_dll, "original", false);
+    if (!load_dll(rebuilt, rebuilt_dll, "rebuilt")) return 1;
+
+    SYSTEMTIME now;
+    GetLocalTime(&now);
+    char timestamp[64];
+    sprintf_s(timestamp, sizeof(timestamp), "%04u-%02u-%02uT%02u:%02u:%02u.%03u",
+              now.wYear, now.wMonth, now.wDay, now.wHour, now.wMinute, now.wSecond, now.wMilliseconds);
+
+    char temp_dir[MAX_PATH];
+    GetTempPathA(MAX_PATH, temp_dir);
+    std::string scratch = std::string(temp_dir) + json_format("aud_matrix_%lu", GetCurrentProcessId());
+
+    std::vector<MatrixTest> tests;
+    bool orig_ok = false;
+    if (orig.module) tests.push_back(matrix_versions(orig, rebuilt));
+    tests.push_back(matrix_init(orig, rebuilt, orig_ok));
+    if (orig.module) tests.push_back(matrix_exports(orig, rebuilt));
+    if (!orig_ok) {
+        fprintf(stderr, "NOTE: Original DLL 3-phase init failed, testing rebuilt only\n");
+    }
+
+    SampleBuffer a_buf = { NULL, 0 };
+    SampleBuffer b_buf = { NULL, 0 };
+    std::vector<unsigned char> raw;
+    for (size_t i = 0; i < test_files.size(); i++) {
+        if (orig_ok) {
+            tests.push_back(matrix_file_io_parity(orig, rebuilt, test_files[i], a_buf, raw));
+        } else {
+            tests.push_back(matrix_file_io_rebuilt(rebuilt, test_files[i]));
+        }
+        wchar_t path_w[MAX_PATH];
+        MultiByteToWideChar(CP_UTF8, 0, test_files[i].c_str(), -1, path_w, MAX_PATH);
+        if (is_text_format(path_w) && rebuilt.Aud_TextFileAOpenW && rebuilt.Aud_ReadLineAInFile &&
+            rebuilt.Aud_TextFileAClose) {
+            tests.push_back(matrix_text_file(rebuilt, test_files[i]));
+        }
+    }
+    if (orig_ok) {
+        for (size_t e = 0; e < sizeof(g_roundtrip_exts) / sizeof(g_roundtrip_exts[0]); e++) {
+            tests.push_back(matrix_put(orig, rebuilt, g_roundtrip_exts[e], scratch, a_buf, b_buf));
+        }
+        tests.push_back(matrix_errors(orig, rebuilt, scratch));
+    }
+    buffer_free(a_buf);
+    buffer_free(b_buf);
+
+    unsigned int passed = 0, failed = 0;
+    for (size_t i = 0; i < tests.size(); i++) {
+        print_matrix_summary(tests[i]);
+        if (tests[i].passed) passed++; else failed++;
+    }
+
+    printf("{\n  \"timestamp\": \"%s\",\n  \"passed\": %u,\n  \"failed\": %u,\n  \"total\": %u,\n"
+           "  \"results\": [", timestamp, passed, failed, passed + failed);
+    for (size_t i = 0; i < tests.size(); i++) {
+        printf("%s\n    {\n      \"test\": ", i > 0 ? "," : "");
+        print_json_string(tests[i].test.c_str());
+        printf(",\n      \"passed\": %s,\n      \"details\": [", tests[i].passed ? "true" : "false");
+        for (size_t j = 0; j < tests[i].details.size(); j++) {
+            printf("%s\n        %s", j > 0 ? "," : "", tests[i].details[j].c_str());
+        }
+        printf("\n      ]\n    }");
+    }
+    printf("\n  ]\n}\n");
+
+    unload_dll(orig);
+    unload_dll(rebuilt);
+    fprintf(stderr, "\nMatrix: %u tests (%u exports) in %.1f ms\n", passed + failed,
+            (unsigned)MATRIX_EXPORTS, timer_ms(t0, timer_now()));
+    fprintf(stderr, "  Passed: %u/%u\n  Failed: %u/%u\n", passed, passed + failed, failed, passed + failed);
+    if (failed == 0) {
+        fprintf(stderr, "\n[OK] PARITY CHECK PASSED\n");
+        return 0;
+    }
+    fprintf(stderr, "\n[FAIL] PARITY CHECK FAILED\n");
+    return 1;
+}
+
+void print_usage(const char* exe) {
+    fprintf(stderr, "Usage: %s [options] <original_dll> <rebuilt_dll> <test_file | test_dir | @manifest>\n", exe);
+    fprintf(stderr, "\nThis MFC host application tests target.dll file I/O.\n");
+    fprintf(stderr, "The original DLL requires MFC context to work properly.\n");
+    fprintf(stderr, "A directory or @manifest runs every file with each DLL loaded once.\n");
+    fprintf(stderr, "\nOptions:\n");
+    fprintf(stderr, "  --help            Print this text\n");
+    fprintf(stderr, "  --jobs N          Split the batch across N worker processes (0 = all CPUs)\n");
+    fprintf(stderr, "  --timeout SEC     Kill workers still running SEC seconds after start (--fuzz: hang limit\n");
+    fprintf(stderr, "                    per execution, default 10)\n");
+    fprintf(stderr, "  --max-ulp N       Tolerated per-sample ULP distance (default 0 = bit-exact)\n");
+    fprintf(stderr, "  --no-simd         Use the scalar diff kernel even if AVX2 is available\n");
+    fprintf(stderr, "  --format NAME     Parity output: json (default) or binary record stream\n");
+    fprintf(stderr, "                    (read with aggregate_results.py)\n");
+    fprintf(stderr, "  --access-orders   Read channels in reverse, shuffled, sparse and one-per-open\n");
+    fprintf(stderr, "                    order and check each against the sequential read\n");
+    fprintf(stderr, "  --scale           Time and peak working set per file (one process per file/DLL)\n");
+    fprintf(stderr, "  --startup N       N fresh processes per DLL, timing DLL load to\n");
+    fprintf(stderr, "                    the first sample of the first file\n");
+    fprintf(stderr, "  --alloc-soak N    N open/close cycles per DLL (0 = 100000) in fresh processes,\n");
+    fprintf(stderr, "                    counting heap calls and fragmentation; fails on failed\n");
+    fprintf(stderr, "                    opens, leaked heap blocks, private bytes or handles\n");
+    fprintf(stderr, "  --soak SECONDS    Loop the corpus this long per DLL (both at once), with latency\n");
+    fprintf(stderr, "                    histograms and handle / memory samples; fails on leaks,\n");
+    fprintf(stderr, "                    memory creep or p99 growth in the rebuilt DLL\n");
+    fprintf(stderr, "  --soak-interval S Seconds per soak sampling window (default 60)\n");
+    fprintf(stderr, "  --matrix          Call all 29 exports on both DLLs (three-phase init for the\n");
+    fprintf(stderr, "                    original) and print parity_test.py's results JSON\n");
+    fprintf(stderr, "  --detect          Classify the corpus by magic bytes (host table, no DLL is loaded)\n");
+    fprintf(stderr, "  --fuzz N          N in-process differential fuzz executions seeded from the corpus\n");
+    fprintf(stderr, "  --fuzz-seed S     PRNG seed (default fixed), --fuzz-max-bytes N (default 262144),\n");
+    fprintf(stderr, "                    --fuzz-out DIR for finding inputs (default fuzz_findings)\n");
+    fprintf(stderr, "  --roundtrip       Write WAV/ETM through both DLLs and read back; the last\n");
+    fprintf(stderr, "                    argument is the output directory instead of the corpus\n");
+    fprintf(stderr, "  --roundtrip-channels N, --roundtrip-samples N\n");
+    fprintf(stderr, "                    Round-trip signal shape (default 8 x 1048576)\n");
+    fprintf(stderr, "\nParity records:\n");
+    fprintf(stderr, "  Files open with their extension's format code; the magic bytes are only\n");
+    fprintf(stderr, "  reported (sniffed_format). Each record lists every channel of every file_idx\n");
+    fprintf(stderr, "  with sample count, first/last sample and call timings, plus a \"memory\" block\n");
+    fprintf(stderr, "  (working set, private bytes and the DLL's own heap calls around the open).\n");
+    fprintf(stderr, "  The rebuilt record adds a \"compare\" block: max ULP distance, max absolute\n");
+    fprintf(stderr, "  error and first divergence over every channel both DLLs read.\n");
+    fprintf(stderr, "  --jobs gives worker K files K, K + N, K + 2N, ... in its own process and merges\n");
+    fprintf(stderr, "  the records back into serial order; --timeout is one deadline for the batch.\n");
+}
+
+int main(int argc, char* argv[]) {
+    // Initialize MFC
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        fprintf(stderr, "ERROR: MFC initialization failed\n");
+        return 1;
+    }
+
+    timer_init();
+
+    HostOptions opts;
+    opts.jobs = 1;
+    opts.shard_index = -1;
+    opts.shard_count = 0;
+    opts.worker_timeout_ms = INFINITE;
+    opts.max_ulp = 0;
+    opts.use_simd = true;
+    opts.scale = false;
+    opts.access_orders = false;
+    opts.detect = false;
+    opts.matrix = false;
+    opts.startup_runs = 0;
+    opts.alloc_soak_opens = 0;
+    opts.soak_seconds = 0;
+    opts.soak_interval = 60;
+    opts.fuzz_iterations = 0;
+    opts.fuzz_seed = 0;
+    opts.fuzz_max_bytes = 262144;
+    opts.fuzz_out = "fuzz_findings";
+    opts.roundtrip = false;
+    opts.roundtrip_channels = 8;
+    opts.roundtrip_samples = 1048576;
+    opts.binary = false;
+    const char* scale_probe = NULL;
+    const char* roundtrip_probe = NULL;
+    const char* startup_probe = NULL;
+    const char* alloc_soak_probe = NULL;
+    const char* soak_probe = NULL;
+
+    int argi = 1;
+    while (argi < argc && strncmp(argv[argi], "--", 2) == 0) {
+        const char* opt = argv[argi++];
+        if (strcmp(opt, "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (strcmp(opt, "--no-simd") == 0) {
+            opts.use_simd = false;
+            continue;
+        }
+        if (strcmp(opt, "--scale") == 0) {
+            opts.scale = true;
+            continue;
+        }
+        if (strcmp(opt, "--access-orders") == 0) {
+            opts.access_orders = true;
+            continue;
+        }
+        if (strcmp(opt, "--detect") == 0) {
+            opts.detect = true;
+            continue;
+        }
+        if (strcmp(opt, "--roundtrip") == 0) {
+            opts.roundtrip = true;
+            continue;
+        }
+        if (strcmp(opt, "--matrix") == 0) {
+            opts.matrix = true;
+            continue;
+        }
+        if (argi >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(opt, "--jobs") == 0) {
+            opts.jobs = atoi(argv[argi++]);
+            if (opts.jobs <= 0) {
+                SYSTEM_INFO si;
+                GetSystemInfo(&si);
+                opts.jobs = (int)si.dwNumberOfProcessors;
+            }
+        } else if (strcmp(opt, "--max-ulp") == 0) {
+            opts.max_ulp = _strtoui64(argv[argi++], NULL, 10);
+        } else if (strcmp(opt, "--format") == 0) {
+            if (strcmp(argv[argi], "binary") == 0) {
+                opts.binary = true;
+            } else if (strcmp(argv[argi], "json") != 0) {
+                fprintf(stderr, "ERROR: --format expects json or binary, got %s\n", argv[argi]);
+                return 1;
+            }
+            argi++;
+        } else if (strcmp(opt, "--timeout") == 0) {
+            opts.worker_timeout_ms = (unsigned int)atoi(argv[argi++]) * 1000;
+        } else if (strcmp(opt, "--fuzz") == 0) {
+            opts.fuzz_iterations = _strtoui64(argv[argi++], NULL, 10);
+        } else if (strcmp(opt, "--fuzz-seed") == 0) {
+            opts.fuzz_seed = _strtoui64(argv[argi++], NULL, 0);
+        } else if (strcmp(opt, "--fuzz-max-bytes") == 0) {
+            opts.fuzz_max_bytes = (unsigned int)atoi(argv[argi++]);
+        } else if (strcmp(opt, "--fuzz-out") == 0) {
+            opts.fuzz_out = argv[argi++];
+        } else if (strcmp(opt, "--roundtrip-channels") == 0) {
+            opts.roundtrip_channels = (unsigned int)atoi(argv[argi++]);
+        } else if (strcmp(opt, "--roundtrip-samples") == 0) {
+            opts.roundtrip_samples = (unsigned int)atoi(argv[argi++]);
+        } else if (strcmp(opt, "--roundtrip-probe") == 0) {
+            roundtrip_probe = argv[argi++];
+        } else if (strcmp(opt, "--startup") == 0) {
+            opts.startup_runs = (unsigned int)atoi(argv[argi++]);
+            if (opts.startup_runs == 0) opts.startup_runs = 1;
+        } else if (strcmp(opt, "--startup-probe") == 0) {
+            startup_probe = argv[argi++];
+        } else if (strcmp(opt, "--alloc-soak") == 0) {
+            opts.alloc_soak_opens = (unsigned int)atoi(argv[argi++]);
+            if (opts.alloc_soak_opens == 0) opts.alloc_soak_opens = 100000;
+        } else if (strcmp(opt, "--alloc-soak-probe") == 0) {
+            alloc_soak_probe = argv[argi++];
+        } else if (strcmp(opt, "--soak") == 0) {
+            opts.soak_seconds = (unsigned int)atoi(argv[argi++]);
+            if (opts.soak_seconds == 0) opts.soak_seconds = 1;
+        } else if (strcmp(opt, "--soak-interval") == 0) {
+            opts.soak_interval = (unsigned int)atoi(argv[argi++]);
+            if (opts.soak_interval == 0) opts.soak_interval = 1;
+        } else if (strcmp(opt, "--soak-probe") == 0) {
+            soak_probe = argv[argi++];
+        } else if (strcmp(opt, "--scale-probe") == 0) {
+            scale_probe = argv[argi++];
+        } else if (strcmp(opt, "--shard") == 0) {
+            if (sscanf_s(argv[argi++], "%d/%d", &opts.shard_index, &opts.shard_count) != 2 ||
+                opts.shard_index < 0 || opts.shard_index >= opts.shard_count) {
+                fprintf(stderr, "ERROR: --shard expects K/N\n");
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "ERROR: Unknown option: %s\n", opt);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - argi < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const char* original_dll = argv[argi];
+    const char* rebuilt_dll = argv[argi + 1];
+    const char* target = argv[argi + 2];
+
+    if (scale_probe) {
+        return run_scale_probe(scale_probe, original_dll, rebuilt_dll, target);
+    }
+    if (startup_probe) {
+        return run_startup_probe(startup_probe, original_dll, rebuilt_dll, target);
+    }
+    if (roundtrip_probe) {
+        return run_roundtrip_probe(opts, roundtrip_probe, original_dll, rebuilt_dll, target);
+    }
+    if (opts.roundtrip) {
+        if (opts.roundtrip_channels == 0 || opts.roundtrip_samples == 0) {
+            fprintf(stderr, "ERROR: --roundtrip needs at least one channel and one sample\n");
+            return 1;
+        }
+        CreateDirectoryA(target, NULL);
+        fprintf(stderr, "Original DLL: %s\n", original_dll);
+        fprintf(stderr, "Rebuilt DLL: %s\n", rebuilt_dll);
+        return run_roundtrip(opts, original_dll, rebuilt_dll, target);
+    }
+
+    std::vector<std::string> test_files;
+    bool batch = true;
+    if (target[0] == '@') {
+        if (!collect_manifest(target + 1, test_files)) return 1;
+    } else if (is_directory(target)) {
+        if (!collect_directory(target, test_files)) return 1;
+    } else {
+        test_files.push_back(target);
+        batch = false;
+    }
+    if (alloc_soak_probe) {
+        return run_alloc_soak_probe(opts, alloc_soak_probe, test_files, original_dll, rebuilt_dll);
+    }
+    if (soak_probe) {
+        return run_soak_probe(opts, soak_probe, test_files, original_dll, rebuilt_dll);
+    }
+
+    // Worker: keep only this shard's files, every shard_count-th from shard_index
+    if (opts.shard_index >= 0) {
+        std::vector<std::string> shard;
+        for (size_t i = (size_t)opts.shard_index; i < test_files.size(); i += (size_t)opts.shard_count) {
+            shard.push_back(test_files[i]);
+        }
+        test_files.swap(shard);
+        batch = true;
+    }
+
+    if (opts.use_simd && cpu_has_avx2()) {
+        g_diff_kernel = diff_avx2;
+    }
+
+    fprintf(stderr, "Original DLL: %s\n", original_dll);
+    fprintf(stderr, "Rebuilt DLL: %s\n", rebuilt_dll);
+    fprintf(stderr, "Diff kernel: %s\n", g_diff_kernel == diff_avx2 ? "avx2" : "scalar");
+    if (batch && opts.shard_index < 0) {
+        fprintf(stderr, "Batch: %u files from %s\n", (unsigned)test_files.size(), target);
+    }
+
+    if (opts.binary && (opts.matrix || opts.detect || opts.fuzz_iterations > 0 ||
+                        opts.startup_runs > 0 || opts.alloc_soak_opens > 0 ||
+                        opts.soak_seconds > 0 || opts.scale)) {
+        fprintf(stderr, "NOTE: --format binary covers the parity check only, writing JSON\n");
+    }
+    if (opts.matrix) {
+        return run_matrix(test_files, original_dll, rebuilt_dll);
+    }
+    if (opts.detect) {
+        return run_detect(test_files);
+    }
+    if (opts.fuzz_iterations > 0) {
+        return run_fuzz(opts, test_files, original_dll, rebuilt_dll);
+    }
+    if (opts.startup_runs > 0) {
+        return run_startup(opts, test_files, original_dll, rebuilt_dll);
+    }
+    if (opts.alloc_soak_opens > 0) {
+        return run_alloc_soak(opts, test_files, original_dll, rebuilt_dll, target);
+    }
+    if (opts.soak_seconds > 0) {
+        return run_soak(opts, test_files, original_dll, rebuilt_dll, target);
+    }
+    if (opts.scale) {
+        return run_scale(opts, test_files, original_dll, rebuilt_dll);
+    }
+    if (batch && opts.shard_index < 0 && opts.jobs > 1 && test_files.size() > 1) {
+        return run_parallel(opts, test_files, original_dll, rebuilt_dll, target);
+    }
+    return run_serial(opts, test_files, batch, original_dll, rebuilt_dll);
+}
@@ -7,10 +7,15 @@
  * Compile with Visual Studio:
  *   cl /EHsc /MD mfc_test_harness.cpp /link /SUBSYSTEM:CONSOLE
  *
+ * Each record carries the wall time of every Aud_* call and the process
+ * working set / private bytes before Aud_OpenGetFile and after
+ * Aud_CloseGetFile. Per-DLL heap call counts are in mfc_host.
+ *
  * Or use MSBuild with the provided .vcxproj
  */
 
 #include <windows.h>
+#include <psapi.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -26,14 +31,61 @@ typedef int (__cdecl *Aud_CloseGetFile_t)(void);
 
 #define AUD_MAGIC 0x42754C2E
 
+#pragma comment(lib, "psapi.lib")
+
+// Wall time of each Aud_* call, in milliseconds (QueryPerformanceCounter)
+struct CallTimes {
+    double init_ms;
+    double open_ms;
+    double num_files_ms;
+    double num_channels_ms;
+    double close_ms;
+};
+
+// Process memory around the open/close cycle (PROCESS_MEMORY_COUNTERS_EX)
+struct CycleMemory {
+    SIZE_T working_set_before;
+    SIZE_T working_set_after;
+    SIZE_T peak_working_set;
+    SIZE_T private_bytes_before;
+    SIZE_T private_bytes_after;
+};
+
+static LARGE_INTEGER g_qpc_freq;
+
+static void sample_memory(SIZE_T* working_set, SIZE_T* private_bytes, SIZE_T* peak_working_set) {
+    PROCESS_MEMORY_COUNTERS_EX pmc;
+    memset(&pmc, 0, sizeof(pmc));
+    pmc.cb = sizeof(pmc);
+    GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc));
+    *working_set = pmc.WorkingSetSize;
+    *private_bytes = pmc.PrivateUsage;
+    if (peak_working_set) *peak_working_set = pmc.PeakWorkingSetSize;
+}
+
+static double elapsed_ms(const LARGE_INTEGER& start, const LARGE_INTEGER& end) {
+    return (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)g_qpc_freq.QuadPart;
+}
+
 void print_json_result(const char* dll_name, const char* test_file,
-                       int open_ret, int num_files, int num_channels) {
+                       int open_ret, int num_files, int num_channels,
+                       const CallTimes& t, const CycleMemory& m) {
     printf("{\n");
     printf("  \"dll\": \"%s\",\n", dll_name);
     printf("  \"file\": \"%s\",\n", test_file);
+    printf("  \"init_ms\": %.4f,\n", t.init_ms);
     printf("  \"open_ret\": %d,\n", open_ret);
+    printf("  \"open_ms\": %.4f,\n", t.open_ms);
     printf("  \"num_files\": %d,\n", num_files);
-    printf("  \"num_channels\": %d\n", num_channels);
+    printf("  \"num_files_ms\": %.4f,\n", t.num_files_ms);
+    printf("  \"num_channels\": %d,\n", num_channels);
+    printf("  \"num_channels_ms\": %.4f,\n", t.num_channels_ms);
+    printf("  \"close_ms\": %.4f,\n", t.close_ms);
+    printf("  \"working_set_before\": %llu,\n", (unsigned long long)m.working_set_before);
+    printf("  \"working_set_after\": %llu,\n", (unsigned long long)m.working_set_after);
+    printf("  \"peak_working_set\": %llu,\n", (unsigned long long)m.peak_working_set);
+    printf("  \"private_bytes_before\": %llu,\n", (unsigned long long)m.private_bytes_before);
+    printf("  \"private_bytes_after\": %llu\n", (unsigned long long)m.private_bytes_after);
     printf("}\n");
 }
 
@@ -66,33 +118,56 @@ int test_dll(const char* dll_path, const char* dll_name, const wchar_t* test_fil
         return 1;
     }
 
+    CallTimes times = {};
+    LARGE_INTEGER t0, t1;
+
     // Initialize
+    QueryPerformanceCounter(&t0);
     unsigned int session_magic = Aud_InitDll(AUD_MAGIC);
+    QueryPerformanceCounter(&t1);
+    times.init_ms = elapsed_ms(t0, t1);
     if (session_magic == 0) {
         fprintf(stderr, "Aud_InitDll failed for %s\n", dll_name);
         FreeLibrary(hDll);
         return 1;
     }
 
+    CycleMemory mem = {};
+    sample_memory(&mem.working_set_before, &mem.private_bytes_before, NULL);
+
     // Open file
+    QueryPerformanceCounter(&t0);
     int open_ret = Aud_OpenGetFile(0, test_file, L"");
+    QueryPerformanceCounter(&t1);
+    times.open_ms = elapsed_ms(t0, t1);
 
     int num_files = -1;
     int num_channels = -1;
 
     if (open_ret == 0) {
         unsigned int files_count = 0;
+        QueryPerformanceCounter(&t0);
         Aud_GetNumberOfFiles(&files_count);
+        QueryPerformanceCounter(&t1);
+        times.num_files_ms = elapsed_ms(t0, t1);
         num_files = (int)files_count;
 
         unsigned int channels_count = 0;
+        QueryPerformanceCounter(&t0);
         Aud_GetNumberOfChannels(0, &channels_count);
+        QueryPerformanceCounter(&t1);
+        times.num_channels_ms = elapsed_ms(t0, t1);
         num_channels = (int)channels_count;
 
+        QueryPerformanceCounter(&t0);
         Aud_CloseGetFile();
+        QueryPerformanceCounter(&t1);
+        times.close_ms = elapsed_ms(t0, t1);
     }
 
-    print_json_result(dll_name, test_file_name, open_ret, num_files, num_channels);
+    sample_memory(&mem.working_set_after, &mem.private_bytes_after, &mem.peak_working_set);
+
+    print_json_result(dll_name, test_file_name, open_ret, num_files, num_channels, times, mem);
 
     FreeLibrary(hDll);
     return 0;
@@ -108,6 +183,8 @@ int main(int argc, char* argv[]) {
     const char* rebuilt_dll = argv[2];
     const char* test_file = argv[3];
 
+    QueryPerformanceFrequency(&g_qpc_freq);
+
     // Convert test file path to wide string
     int len = MultiByteToWideChar(CP_UTF8, 0, test_file, -1, NULL, 0);
     wchar_t* test_file_w = (wchar_t*)malloc(len * sizeof(wchar_t));
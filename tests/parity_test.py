@@ -16,6 +16,7 @@ Without completing all three phases, file I/O returns error -28.
 """
 
 import ctypes
+import functools
 import json
 import math
 import os
@@ -63,10 +64,63 @@ FORMAT_CODES = {
 }
 
 
+# Magic-byte sniffing table, mirrors g_format_magic in aud_host.h:
+# (format code, family, [(offset, signature), ...]). Entries of one family
+# share a signature and the extension picks among them. Numeric text (ETX,
+# CLIO, LMS) and MonkeyForest SPK have no signature and are left to the
+# extension.
+FORMAT_MAGIC = [
+    (9, "MsWave", [(0, b"RIFF"), (8, b"WAVE")]),
+    (1, "Easera", [(0, b"SDA Easera  ")]),
+    (2, "Easera", [(0, b"SDA Easera  ")]),
+    (3, "AudioMeasureEmd", [(0, b"EASERA10MS")]),
+    (10, "MlssaTim", [(0, b"\xcd\xab\xff\xff")]),
+    (11, "MlssaFrq", [(0, b"\xde\xbc\xff\xff")]),
+    (12, "MonkeyForestDat", [(0, b"M_D ")]),
+    (0, "ClioBinary", [(0, b"\x0bAUDIOMATICA")]),  # .mls/.frs/.imp, auto-detected
+]
+
+SNIFF_BYTES = 512
+
+
+@functools.lru_cache(maxsize=None)
+def sniff_format(file_path: Path) -> tuple[int, str]:
+    """Format code and family from the first SNIFF_BYTES of the file.
+
+    A file whose extension names a format with a signature it does not
+    carry (test_mislabeled.etm) gets 0 ("unknown"). Cached per path; the
+    result is reported next to the open, never used as its format code.
+    """
+    ext_format = FORMAT_CODES.get(file_path.suffix.lower(), 0)
+    try:
+        with open(file_path, "rb") as f:
+            head = f.read(SNIFF_BYTES)
+    except OSError:
+        return ext_format, "extension"
+
+    match = None
+    for code, family, signatures in FORMAT_MAGIC:
+        if not all(head[off:off + len(sig)] == sig for off, sig in signatures):
+            continue
+        if match and match[1] != family:
+            break
+        if match is None or code == ext_format:
+            match = (code, family)
+    if match:
+        return match
+
+    if ext_format and any(code == ext_format for code, _, _ in FORMAT_MAGIC):
+        return 0, "unknown"
+    return ext_format, "extension"
+
+
 def get_format_code(file_path: Path) -> int:
-    """Get format code from file extension."""
-    ext = file_path.suffix.lower()
-    return FORMAT_CODES.get(ext, 0)  # 0 = auto-detect
+    """Get format code from the file extension.
+
+    The parity opens keep the extension's parser so malformed fixtures
+    (bad magic, truncated header) still exercise its error paths.
+    """
+    return FORMAT_CODES.get(file_path.suffix.lower(), 0)
 
 
 class DLLWrapper:
@@ -271,8 +325,9 @@ def test_file_io_parity(original: DLLWrapper, rebuilt: DLLWrapper, test_file: Pa
 
     file_path = str(test_file.resolve())
     format_code = get_format_code(test_file)
+    sniffed_format = sniff_format(test_file)[0]
 
-    # Open file with BOTH DLLs (using correct format code)
+    # Open file with BOTH DLLs (using the extension's format code)
     orig_open = original.open_file(file_path, format_code)
     rebuilt_open = rebuilt.open_file(file_path, format_code)
 
@@ -280,6 +335,7 @@ def test_file_io_parity(original: DLLWrapper, rebuilt: DLLWrapper, test_file: Pa
         "function": "Aud_OpenGetFile",
         "file": test_file.name,
         "format_code": format_code,
+        "sniffed_format": sniffed_format,
         "original": orig_open,
         "rebuilt": rebuilt_open,
         "match": orig_open == rebuilt_open
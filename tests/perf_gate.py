@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+"""Performance-regression gate over repeated mfc_bench / mfc_host runs.
+
+    for /L %i in (1,1,5) do (
+        mfc_bench --iterations 20 --cache warm orig.dll rebuilt.dll test_files > bench_%i.json
+        mfc_host orig.dll rebuilt.dll test_files > host_%i.json
+        mfc_host --startup 10 orig.dll rebuilt.dll test_files > startup_%i.json )
+    python perf_gate.py --bench bench_*.json --host host_*.json --startup startup_*.json --baseline perf_baseline.json
+
+Each run contributes one sample per metric and DLL:
+  throughput/<format>  warm-cache ms per MB over all files of that format
+                       (mfc_bench median_ms and bytes, i.e. 1000 / MB/s)
+  latency/<export>     ms summed over the files both DLLs opened (mfc_host
+                       open_ms, read_ms, ... records)
+  startup/<phase>      median ms from DLL load (or process creation) to the
+                       first sample (mfc_host --startup)
+Lower is better for both. A metric fails when, at 95% confidence, the
+rebuilt DLL is more than --threshold percent slower:
+  - than the original in the same runs (paired per-run time ratios), or
+  - than the baseline: the rebuilt/original ratio is compared with the
+    baseline's, so a baseline from another machine still applies
+    (--absolute compares raw rebuilt times instead).
+Metrics whose original time is under --min-ms are reported but not gated,
+since timer resolution dominates them; for throughput that is the summed
+median ms, not the ms/MB value. The gate fails when no metric is left to
+gate, e.g. because neither DLL opened any file. -o writes the summary in the
+baseline format; commit it as perf_baseline.json to pin a new baseline.
+"""
+
+import argparse
+import glob
+import json
+import math
+import sys
+from datetime import datetime
+
+HOST_EXPORTS = [
+    ("load_ms", "LoadLibraryA"),
+    ("init_ms", "Aud_InitDll"),
+    ("open_ms", "Aud_OpenGetFile"),
+    ("num_files_ms", "Aud_GetNumberOfFiles"),
+    ("num_channels_ms", "Aud_GetNumberOfChannels"),
+    ("size_query_ms", "Aud_GetChannelDataDoubles(NULL)"),
+    ("read_ms", "Aud_GetChannelDataDoubles(buf)"),
+    ("close_ms", "Aud_CloseGetFile"),
+]
+
+# Two-sided 95% Student t quantiles by degrees of freedom
+T95 = {1: 12.706, 2: 4.303, 3: 3.182, 4: 2.776, 5: 2.571, 6: 2.447, 7: 2.365, 8: 2.306,
+       9: 2.262, 10: 2.228, 12: 2.179, 15: 2.131, 20: 2.086, 30: 2.042, 60: 2.000}
+
+
+def t95(df):
+    if df <= 0:
+        return 0.0
+    for k in sorted(T95):
+        if df <= k:
+            return T95[k]
+    return 1.960
+
+
+def stats(values):
+    n = len(values)
+    mean = sum(values) / n if n else 0.0
+    stdev = math.sqrt(sum((v - mean) ** 2 for v in values) / (n - 1)) if n > 1 else 0.0
+    return {"mean": mean, "stdev": stdev, "n": n}
+
+
+def ci(s):
+    half = t95(s["n"] - 1) * s["stdev"] / math.sqrt(s["n"]) if s["n"] > 1 else 0.0
+    return s["mean"] - half, s["mean"] + half
+
+
+def load_records(path):
+    with open(path, encoding="utf-8-sig") as f:     # PowerShell redirects may add a BOM
+        data = json.load(f)
+    return data if isinstance(data, list) else [data]
+
+
+def bench_samples(records, cache):
+    """{metric: {dll: (ms_per_mb, ms)}} for one mfc_bench run; ms is the
+    summed median time the noise floor applies to."""
+    totals = {}
+    for r in records:
+        if r.get("cache") != cache or r.get("open_ret") != 0 or not r.get("bytes"):
+            continue
+        key = "throughput/" + r["format_name"]
+        t = totals.setdefault(key, {}).setdefault(r["dll"], [0.0, 0])
+        t[0] += r["median_ms"]
+        t[1] += r["bytes"]
+    return {key: {dll: (ms / (nbytes / 2**20), ms) for dll, (ms, nbytes) in per_dll.items()}
+            for key, per_dll in totals.items()}
+
+
+def host_samples(records):
+    """{metric: {dll: (ms, ms)}} for one mfc_host run, over files both DLLs opened.
+
+    load_ms and init_ms are paid once per DLL load. A --jobs N run loads the
+    DLLs once per worker and each record carries its worker's value, so the
+    metric is their mean over the records rather than whichever came last.
+    """
+    by_file = {}
+    for r in records:
+        if "dll" in r and "file" in r:
+            by_file.setdefault(r["file"], {})[r["dll"]] = r
+    sums = {}
+    loads = {}
+    for per_dll in by_file.values():
+        if any(per_dll.get(d, {}).get("open_ret") != 0 for d in ("original", "rebuilt")):
+            continue
+        for field, export in HOST_EXPORTS:
+            for dll, r in per_dll.items():
+                if field not in r:
+                    continue                    # Records from hosts before load_ms
+                key = "latency/" + export
+                if field in ("load_ms", "init_ms"):
+                    loads.setdefault(key, {}).setdefault(dll, []).append(r[field])
+                else:
+                    m = sums.setdefault(key, {})
+                    m[dll] = m.get(dll, 0.0) + r[field]
+    for key, per_dll in loads.items():
+        sums[key] = {dll: sum(v) / len(v) for dll, v in per_dll.items()}
+    return {key: {dll: (ms, ms) for dll, ms in per_dll.items()} for key, per_dll in sums.items()}
+
+
+STARTUP_PHASES = ("load_library_ms", "dll_to_first_sample_ms", "process_to_first_sample_ms")
+
+
+def median(values):
+    values = sorted(values)
+    return values[len(values) // 2] if values else None
+
+
+def startup_samples(records):
+    """{metric: {dll: (ms, ms)}} for one mfc_host --startup run."""
+    by_path = {}
+    for r in records:
+        if r.get("ok"):
+            by_path.setdefault((r["dll"], r["init"]), []).append(r)
+    paths = {"original": ("original", "full"), "rebuilt": ("rebuilt", "full")}
+    samples = {}
+    for phase in STARTUP_PHASES:
+        for dll, path in paths.items():
+            value = median(r[phase] for r in by_path.get(path, []) if phase in r)
+            if value is not None:
+                samples.setdefault("startup/" + phase, {})[dll] = (value, value)
+    return samples
+
+
+def collect(runs):
+    """Per metric: per-run lists for original, rebuilt and rebuilt/original,
+    plus original_ms, the original's time in ms for the noise floor."""
+    series = {}
+    for run in runs:
+        for key, per_dll in run.items():
+            if "original" not in per_dll or "rebuilt" not in per_dll:
+                continue
+            s = series.setdefault(key, {"original": [], "rebuilt": [], "ratio": [], "original_ms": []})
+            (orig, orig_ms), (rebuilt, _) = per_dll["original"], per_dll["rebuilt"]
+            s["original"].append(orig)
+            s["rebuilt"].append(rebuilt)
+            s["original_ms"].append(orig_ms)
+            if orig > 0:
+                s["ratio"].append(rebuilt / orig)
+    return {key: {name: stats(values) for name, values in s.items()} for key, s in series.items()}
+
+
+def slower_than(current, reference, limit):
+    """True if current is above reference * limit at 95% confidence (Welch)."""
+    if current["n"] == 0 or reference["n"] == 0:
+        return False
+    diff = current["mean"] - reference["mean"] * limit
+    var = current["stdev"] ** 2 / current["n"] + (reference["stdev"] * limit) ** 2 / reference["n"]
+    df = max(min(current["n"], reference["n"]) - 1, 1) if var > 0 else 0
+    return diff - t95(df) * math.sqrt(var) > 0
+
+
+def gate(metrics, baseline, threshold, min_ms, absolute):
+    """Print the table; returns (failed metric names, number of metrics gated)."""
+    limit = 1.0 + threshold / 100.0
+    failures = []
+    gated = 0
+    print(f"{'metric':<44} {'original':>10} {'rebuilt':>10} {'ratio':>7} {'95% CI':>15} "
+          f"{'baseline':>9}  status")
+    for key in sorted(metrics):
+        m = metrics[key]
+        lo, hi = ci(m["ratio"])
+        base = baseline.get(key) if baseline else None
+        base_ratio = f"{base['ratio']['mean']:9.3f}" if base else f"{'-':>9}"
+        status = "ok"
+        if m["original_ms"]["mean"] < min_ms:
+            status = "noise floor"
+        else:
+            gated += 1
+            reasons = []
+            if lo > limit:
+                reasons.append("vs original")
+            if base:
+                field = "rebuilt" if absolute else "ratio"
+                if slower_than(m[field], base[field], limit):
+                    reasons.append("vs baseline")
+            if reasons:
+                status = "SLOWER " + ", ".join(reasons)
+                failures.append(key)
+        print(f"{key:<44} {m['original']['mean']:10.3f} {m['rebuilt']['mean']:10.3f} "
+              f"{m['ratio']['mean']:7.3f} [{lo:6.3f},{hi:6.3f}] {base_ratio}  {status}")
+    missing = sorted(set(baseline or {}) - set(metrics))
+    for key in missing:
+        print(f"{key:<44} {'(in baseline, not measured)':>44}")
+    return failures, gated
+
+
+def expand(patterns):
+    paths = []
+    for p in patterns or []:
+        paths.extend(sorted(glob.glob(p)) or [p])
+    return paths
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--bench", nargs="*", default=[], help="mfc_bench JSON, one file per run")
+    ap.add_argument("--host", nargs="*", default=[], help="mfc_host JSON, one file per run")
+    ap.add_argument("--startup", nargs="*", default=[], help="mfc_host --startup JSON, one file per run")
+    ap.add_argument("--baseline", help="Baseline JSON (format of -o)")
+    ap.add_argument("--threshold", type=float, default=10.0, help="Allowed slowdown in percent (default 10)")
+    ap.add_argument("--min-ms", type=float, default=0.5, help="Do not gate metrics below this (default 0.5)")
+    ap.add_argument("--cache", default="warm", help="mfc_bench cache mode to use (default warm)")
+    ap.add_argument("--absolute", action="store_true", help="Compare raw rebuilt times with the baseline")
+    ap.add_argument("-o", "--output", help="Write this run's summary (usable as a baseline)")
+    args = ap.parse_args()
+
+    bench_runs = [bench_samples(load_records(p), args.cache) for p in expand(args.bench)]
+    host_runs = [host_samples(load_records(p)) for p in expand(args.host)]
+    startup_runs = [startup_samples(load_records(p)) for p in expand(args.startup)]
+    if not bench_runs and not host_runs and not startup_runs:
+        ap.error("no --bench, --host or --startup runs given")
+    metrics = collect(bench_runs)
+    metrics.update(collect(host_runs))
+    metrics.update(collect(startup_runs))
+
+    baseline = None
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)["metrics"]
+
+    print(f"Runs: {len(bench_runs)} bench, {len(host_runs)} host, {len(startup_runs)} startup; "
+          f"threshold {args.threshold:g}%")
+    if min(len(bench_runs) or 99, len(host_runs) or 99, len(startup_runs) or 99) < 2:
+        print("[WARN] fewer than 2 runs: no confidence interval, point estimates only")
+    failures, gated = gate(metrics, baseline, args.threshold, args.min_ms, args.absolute)
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump({"created": datetime.now().isoformat(), "threshold_pct": args.threshold,
+                       "runs": {"bench": len(bench_runs), "host": len(host_runs),
+                                "startup": len(startup_runs)},
+                       "metrics": metrics}, f, indent=2)
+        print(f"[OK] Wrote {args.output}")
+
+    if failures:
+        print(f"\n[FAIL] PERF GATE FAILED: {len(failures)} metric(s) more than "
+              f"{args.threshold:g}% slower")
+        return 1
+    if gated == 0:
+        # Typically every open failed (no file both DLLs read), so nothing was timed
+        print(f"\n[FAIL] PERF GATE FAILED: no metric above the {args.min_ms:g} ms noise floor "
+              f"with both DLLs measured ({len(metrics)} metric(s) found)")
+        return 1
+    print("\n[OK] PERF GATE PASSED")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Plot mfc_host --scale output: read time and peak working set vs file size.
+
+    mfc_host --scale original.dll rebuilt.dll tests\\scaling_files > scale.json
+    python plot_scaling.py scale.json scale.png
+
+Series are grouped by DLL and by the sample type and channel count taken
+from the generator's file names (scale_<type>_<N>ch_<size>.wav,
+scale_<etm|efr>_<size>.<ext>), so mono and multi-channel WAVs of one type
+are separate lines.
+Without matplotlib the same data is printed as a table.
+"""
+
+import json
+import sys
+from collections import defaultdict
+from pathlib import Path
+
+
+def series_key(record):
+    name = Path(record["file"].replace("\\", "/")).name
+    parts = name.split("_")
+    if len(parts) > 2 and parts[0] == "scale":
+        sample_type = parts[1]
+        if len(parts) > 3 and parts[2].endswith("ch"):
+            sample_type += " " + parts[2]       # e.g. "pcm16 8ch"
+    else:
+        sample_type = Path(name).suffix[1:]
+    return record["dll"], sample_type
+
+
+def load_series(path):
+    with open(path) as f:
+        records = json.load(f)
+    series = defaultdict(list)
+    for r in records:
+        if r.get("open_ret") != 0:
+            continue
+        series[series_key(r)].append((r["file_bytes"] / 2**20,
+                                      r["open_ms"] + r["size_query_ms"] + r["read_ms"],
+                                      r["peak_working_set"] / 2**20))
+    for points in series.values():
+        points.sort()
+    return series
+
+
+def print_table(series):
+    print(f"{'dll':<10} {'type':<12} {'MB':>10} {'ms':>12} {'peak MB':>10}")
+    for (dll, sample_type), points in sorted(series.items()):
+        for size_mb, ms, peak_mb in points:
+            print(f"{dll:<10} {sample_type:<12} {size_mb:>10.1f} {ms:>12.2f} {peak_mb:>10.1f}")
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(f"Usage: {sys.argv[0]} <scale.json> [out.png]")
+        return 1
+
+    series = load_series(sys.argv[1])
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print_table(series)
+        return 0
+
+    fig, (ax_time, ax_mem) = plt.subplots(1, 2, figsize=(14, 6))
+    for (dll, sample_type), points in sorted(series.items()):
+        sizes = [p[0] for p in points]
+        style = "-" if dll == "original" else "--"
+        ax_time.plot(sizes, [p[1] for p in points], style, marker="o", label=f"{dll} {sample_type}")
+        ax_mem.plot(sizes, [p[2] for p in points], style, marker="o", label=f"{dll} {sample_type}")
+
+    for ax, ylabel in ((ax_time, "open + read time (ms)"), (ax_mem, "peak working set (MB)")):
+        ax.set_xscale("log", base=2)
+        ax.set_yscale("log", base=2)
+        ax.set_xlabel("file size (MB)")
+        ax.set_ylabel(ylabel)
+        ax.grid(True, which="both", alpha=0.3)
+    ax_mem.legend(fontsize="small", ncol=2)
+
+    out = sys.argv[2] if len(sys.argv) > 2 else "scaling.png"
+    fig.tight_layout()
+    fig.savefig(out, dpi=120)
+    print(f"[OK] Wrote {out}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+"""Flame graphs and hot spots from mfc_bench --profile, original vs rebuilt.
+
+    mfc_bench --profile results\\profile ..\\dlls\\original\\target.dll ..\\dlls\\rebuilt\\target.dll test_files
+    python profile_report.py results\\profile
+
+Reads every <format>_<dll>.folded file in the directory and writes, next to
+them, one <format>_<dll>.svg flame graph each plus report.md and
+report.html: per format, the functions with the most samples in either DLL
+with self% (sample leaf is in the function) and total% (function is
+anywhere on the stack), and the two flame graphs side by side.
+
+Frames arrive as <module>+0x<rva>. For the two target.dll copies each RVA is
+mapped to the nearest preceding export of that DLL's PE image, so the
+hot-spot names (target!<export>) line up between original and rebuilt;
+internal functions are therefore charged to the export above them. --symbols rebuilt=target.map
+(lines "<hex rva> <name>", e.g. from a linker map or IDA listing) adds
+proper names. Frames in other modules collapse to the module name.
+"""
+
+import argparse
+import bisect
+import html
+import struct
+import sys
+import zlib
+from collections import defaultdict
+from pathlib import Path
+
+DLLS = ("original", "rebuilt")
+FLAME_WIDTH = 1200
+FLAME_ROW = 16
+TOP_FUNCTIONS = 25
+
+
+def pe_exports(path):
+    """[(rva, name)] of a PE image's named exports, sorted by RVA."""
+    data = Path(path).read_bytes()
+    pe = struct.unpack_from("<I", data, 0x3C)[0]
+    if data[pe:pe + 4] != b"PE\0\0":
+        raise ValueError(f"{path}: not a PE image")
+    sections, opt_size = struct.unpack_from("<H12xH", data, pe + 6)
+    opt = pe + 24
+    magic = struct.unpack_from("<H", data, opt)[0]
+    dirs = opt + (96 if magic == 0x10B else 112)
+    export_rva, export_size = struct.unpack_from("<II", data, dirs)
+    if not export_size:
+        return []
+    table = []
+    for i in range(sections):
+        s = opt + opt_size + 40 * i
+        vsize, vaddr, rsize, raddr = struct.unpack_from("<IIII", data, s + 8)
+        table.append((vaddr, max(vsize, rsize), raddr))
+
+    def offset(rva):
+        for vaddr, size, raddr in table:
+            if vaddr <= rva < vaddr + size:
+                return rva - vaddr + raddr
+        raise ValueError(f"{path}: RVA 0x{rva:x} outside every section")
+
+    def cstr(rva):
+        o = offset(rva)
+        return data[o:data.index(b"\0", o)].decode("ascii", "replace")
+
+    e = offset(export_rva)
+    n_names, functions, names, ordinals = struct.unpack_from("<4xIIII", data, e + 20)
+    symbols = []
+    for i in range(n_names):
+        name_rva = struct.unpack_from("<I", data, offset(names) + 4 * i)[0]
+        ordinal = struct.unpack_from("<H", data, offset(ordinals) + 2 * i)[0]
+        rva = struct.unpack_from("<I", data, offset(functions) + 4 * ordinal)[0]
+        if not export_rva <= rva < export_rva + export_size:     # Skip forwarders
+            symbols.append((rva, cstr(name_rva)))
+    return sorted(symbols)
+
+
+def load_map(path):
+    symbols = []
+    with open(path) as f:
+        for line in f:
+            parts = line.split(None, 1)
+            if len(parts) == 2:
+                try:
+                    symbols.append((int(parts[0], 16), parts[1].strip()))
+                except ValueError:
+                    continue
+    return symbols
+
+
+class Symbolizer:
+    def __init__(self, symbols):
+        self.tables = {}
+        for dll, syms in symbols.items():
+            by_rva = {}
+            for rva, name in sorted(set(syms)):
+                by_rva.setdefault(rva, name)        # Aud_InitDll over its Aud_InitDll@4 alias
+            rvas = sorted(by_rva)
+            self.tables[dll] = (rvas, [by_rva[rva] for rva in rvas])
+
+    def frame(self, frame):
+        module, sep, rva = frame.rpartition("+0x")
+        if not sep:
+            return frame
+        if module not in self.tables:
+            return module
+        rvas, names = self.tables[module]
+        i = bisect.bisect_right(rvas, int(rva, 16)) - 1
+        return f"target!{names[i]}" if i >= 0 else f"target!0x{int(rva, 16):x}"
+
+
+def load_folded(path, symbolizer):
+    """{tuple of symbolized frames, root first: count}"""
+    stacks = defaultdict(int)
+    with open(path) as f:
+        for line in f:
+            stack, _, count = line.rstrip("\n").rpartition(" ")
+            if not stack:
+                continue
+            frames = []
+            for raw in stack.split(";"):
+                name = symbolizer.frame(raw)
+                if not frames or frames[-1] != name:    # Fold recursion into one frame
+                    frames.append(name)
+            stacks[tuple(frames)] += int(count)
+    return stacks
+
+
+def hot_spots(stacks):
+    """{function: (self samples, total samples)} and the sample count."""
+    self_counts = defaultdict(int)
+    total_counts = defaultdict(int)
+    for frames, count in stacks.items():
+        self_counts[frames[-1]] += count
+        for name in set(frames):
+            total_counts[name] += count
+    return {name: (self_counts[name], total_counts[name]) for name in total_counts}, \
+        sum(stacks.values())
+
+
+def flame_svg(stacks, title):
+    tree = {}                   # name -> [count, children]
+    for frames, count in stacks.items():
+        level = tree
+        for name in frames:
+            node = level.setdefault(name, [0, {}])
+            node[0] += count
+            level = node[1]
+    total = sum(node[0] for node in tree.values()) or 1
+
+    def depth(level):
+        return 1 + max((depth(node[1]) for node in level.values()), default=0) if level else 0
+
+    height = (depth(tree) + 2) * FLAME_ROW
+    rects = []
+
+    def draw(level, x, row):
+        for name in sorted(level):
+            count, children = level[name]
+            w = FLAME_WIDTH * count / total
+            y = height - (row + 2) * FLAME_ROW
+            hue = 10 + zlib.crc32(name.split("!")[-1].encode()) % 50
+            label = html.escape(name)
+            tip = f"{label} ({count} samples, {100.0 * count / total:.1f}%)"
+            text = label if w > 7 * len(name) else (label[:int(w / 7) - 2] + ".." if w > 35 else "")
+            rects.append(f'<g><title>{tip}</title><rect x="{x:.2f}" y="{y}" width="{max(w - 0.5, 0.1):.2f}" '
+                         f'height="{FLAME_ROW - 1}" fill="hsl({hue},90%,60%)"/>'
+                         f'<text x="{x + 3:.2f}" y="{y + FLAME_ROW - 4}">{text}</text></g>')
+            draw(children, x, row + 1)
+            x += w
+
+    draw(tree, 0.0, 0)
+    return (f'<svg xmlns="http://www.w3.org/2000/svg" width="{FLAME_WIDTH}" height="{height}" '
+            f'font-family="monospace" font-size="11">'
+            f'<text x="4" y="12">{html.escape(title)} - {total} samples</text>'
+            + "".join(rects) + "</svg>\n")
+
+
+def report(directory, symbolizer):
+    profiles = defaultdict(dict)           # format -> dll -> stacks
+    for path in sorted(Path(directory).glob("*.folded")):
+        fmt, _, dll = path.stem.rpartition("_")
+        if dll in DLLS:
+            profiles[fmt][dll] = load_folded(path, symbolizer)
+    if not profiles:
+        print(f"[ERROR] No <format>_<dll>.folded files in {directory}")
+        return 1
+
+    md = ["# Profile: original vs rebuilt", "",
+          "self% = samples whose leaf is in the function, total% = samples with the function "
+          "anywhere on the stack.", ""]
+    page = ["<!DOCTYPE html><html><head><meta charset='utf-8'><title>Profile</title>"
+            "<style>body{font-family:sans-serif}table{border-collapse:collapse}"
+            "td,th{border:1px solid #ccc;padding:2px 6px;text-align:right}"
+            "td:first-child{text-align:left;font-family:monospace}</style></head><body>"
+            "<h1>Profile: original vs rebuilt</h1>"]
+    for fmt, per_dll in sorted(profiles.items()):
+        spots = {dll: hot_spots(stacks) for dll, stacks in per_dll.items()}
+        for dll, stacks in per_dll.items():
+            svg = flame_svg(stacks, f"{fmt} / {dll}")
+            (Path(directory) / f"{fmt}_{dll}.svg").write_text(svg)
+
+        def pct(dll, name, i):
+            if dll not in spots:
+                return "-"
+            counts, n = spots[dll]
+            return f"{100.0 * counts.get(name, (0, 0))[i] / n:.1f}" if n else "-"
+
+        names = set()
+        for counts, _ in spots.values():
+            names.update(counts)
+        ranked = sorted(names, key=lambda name: -max(spots[d][0].get(name, (0, 0))[0]
+                                                       for d in spots))[:TOP_FUNCTIONS]
+        samples = ", ".join(f"{dll} {spots[dll][1]}" for dll in DLLS if dll in spots)
+
+        md += [f"## {fmt}", "", f"Samples: {samples}", "",
+               "| function | original self% | rebuilt self% | original total% | rebuilt total% |",
+               "|---|---:|---:|---:|---:|"]
+        md += [f"| `{name}` | {pct('original', name, 0)} | {pct('rebuilt', name, 0)} | "
+               f"{pct('original', name, 1)} | {pct('rebuilt', name, 1)} |" for name in ranked]
+        md += ["", " ".join(f"![{fmt} {dll}]({fmt}_{dll}.svg)" for dll in DLLS if dll in per_dll), ""]
+
+        page.append(f"<h2>{html.escape(fmt)}</h2><p>Samples: {html.escape(samples)}</p><table>"
+                    "<tr><th>function</th><th>original self%</th><th>rebuilt self%</th>"
+                    "<th>original total%</th><th>rebuilt total%</th></tr>")
+        page += [f"<tr><td>{html.escape(name)}</td><td>{pct('original', name, 0)}</td>"
+                 f"<td>{pct('rebuilt', name, 0)}</td><td>{pct('original', name, 1)}</td>"
+                 f"<td>{pct('rebuilt', name, 1)}</td></tr>" for name in ranked]
+        page.append("</table><div style='display:flex;gap:8px;overflow-x:auto'>")
+        page += [f"<div><img src='{fmt}_{dll}.svg'></div>" for dll in DLLS if dll in per_dll]
+        page.append("</div>")
+    page.append("</body></html>")
+
+    (Path(directory) / "report.md").write_text("\n".join(md) + "\n")
+    (Path(directory) / "report.html").write_text("\n".join(page) + "\n")
+    print(f"[OK] {len(profiles)} format(s): wrote flame graphs, report.md and report.html to {directory}")
+    return 0
+
+
+def main():
+    here = Path(__file__).resolve().parent
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("directory", help="mfc_bench --profile output directory")
+    ap.add_argument("--dll", nargs="*", default=[], metavar="NAME=PATH",
+                    help="DLL images for export symbols (default ../dlls/<name>/target.dll)")
+    ap.add_argument("--symbols", nargs="*", default=[], metavar="NAME=MAP",
+                    help="Extra '<hex rva> <name>' symbol files per DLL")
+    args = ap.parse_args()
+
+    images = {dll: here.parent / "dlls" / dll / "target.dll" for dll in DLLS}
+    images.update(dict(arg.split("=", 1) for arg in args.dll))
+    symbols = defaultdict(list)
+    for dll, path in images.items():
+        if Path(path).exists():
+            symbols[dll] += pe_exports(path)
+        else:
+            print(f"[WARN] {path} not found, {dll} frames stay unsymbolized")
+    for arg in args.symbols:
+        dll, path = arg.split("=", 1)
+        symbols[dll] += load_map(path)
+    return report(args.directory, Symbolizer(symbols))
+
+
+if __name__ == "__main__":
+    sys.exit(main())